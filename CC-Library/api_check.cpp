@@ -0,0 +1,77 @@
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <string>
+#include <unordered_set>
+//Custom libraries
+// Every operator new of this program is counted
+#define CC_ALLOCATION_HOOKS
+#include "cc/Edge.hpp"
+#include "cc/Components.hpp"
+#include "cc/Generators.hpp"
+#include "cc/MemoryTracker.hpp"
+
+using namespace std;
+
+// Check of the embeddable API: every shared-memory engine labels the same graph twice with one cc::Context.
+// The second call must find the same components as the serial engine and allocate nothing, except the randomized
+// engine on several threads: the order of its concurrent hooks changes the rounds, the allocations are only printed
+int main(int argc, char* argv[])
+{
+	string spec_name = argc >= 2 ? argv[1] : "rmat:16:8";
+	cc::GraphSpec spec;
+	if (argc > 3 || !cc::parse_graph_spec(spec_name, spec) || cc::graph_edge_count(spec) > cc::MAX_EDGE_COUNT)
+	{
+		cout << "Usage: api_check [SPEC] [--threads=N]" << endl;
+		cout << "SPEC: rmat:SCALE:DEGREE | er:N:M | grid2d:X:Y | grid3d:X:Y:Z | path:N | islands:COUNT:SIZE" << endl;
+		return 1;
+	}
+	cc::Options options;
+	if (argc == 3 && string(argv[2]).compare(0, 10, "--threads=") == 0)
+		options.threads = atoi(argv[2] + 10);
+
+	vector<Edge> edges;
+	uint32_t vertex_count = cc::generate_graph(spec, edges);
+	// The API reads the edges in any orientation
+	for (size_t i = 0; i < edges.size(); i += 2)
+		swap(edges[i].from, edges[i].to);
+
+	vector<uint32_t> reference(vertex_count), labels(vertex_count);
+	options.engine = cc::Engine::SERIAL;
+	cc::components(edges, vertex_count, reference.data(), options);
+	size_t reference_components = unordered_set<uint32_t>(reference.begin(), reference.end()).size();
+
+	int threads = options.threads > 0 ? options.threads : omp_get_max_threads();
+	cc::MemoryTracker& tracker = cc::MemoryTracker::instance();
+	bool passed = true;
+	for (cc::Engine engine : {cc::Engine::SERIAL, cc::Engine::OMP_DETERMINISTIC, cc::Engine::OMP_RANDOMIZED})
+	{
+		options.engine = engine;
+		cc::Context context;
+		uint64_t allocations[2], allocated[2];
+		for (int call = 0; call < 2; call++)
+		{
+			uint64_t allocations_before = tracker.allocations_, allocated_before = tracker.allocated_;
+			context.components(edges, vertex_count, labels.data(), options);
+			allocations[call] = tracker.allocations_ - allocations_before;
+			allocated[call] = tracker.allocated_ - allocated_before;
+		}
+
+		// Same components as the serial engine: the label of an edge is the label of both its endpoints
+		bool same_components = unordered_set<uint32_t>(labels.begin(), labels.end()).size() == reference_components;
+		for (const Edge& edge : edges)
+			same_components = same_components && labels[edge.from] == labels[edge.to];
+
+		cout << cc::engine_name(engine) << ": " << context.iterations_ << " iterations, first call " << allocations[0]
+			<< " allocations (" << allocated[0] << " bytes), second call " << allocations[1] << " allocations ("
+			<< allocated[1] << " bytes)" << (same_components ? "" : ", wrong components") << endl;
+		bool reproducible = engine != cc::Engine::OMP_RANDOMIZED || threads == 1;
+		passed = passed && same_components && (allocations[1] == 0 || !reproducible);
+	}
+
+	cout << "Graph: " << spec_name << " Components: " << reference_components << (passed ? " PASSED" : " FAILED") << endl;
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,288 @@
+#ifdef CC_MPI
+#include "../CSE613-MPI/utils/mpi_parallel_cc_utils.hpp"
+#endif
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+//Custom libraries
+#include "cc/Edge.hpp"
+#include "cc/DisjointSets.hpp"
+#include "cc/OpenMPEngines.hpp"
+#include "cc/Generators.hpp"
+
+using namespace std;
+
+// Microbenchmarks of the kernels on generated graphs, one measurement per kernel, graph and thread count.
+// The setup of every repetition (fresh labels, fresh sets) is not timed. The JSON report has the layout of
+// Google Benchmark (context + benchmarks, real_time in ns), so its compare tools can diff two commits
+
+// Inputs of the kernels for one graph
+struct BenchGraph
+{
+	string spec;
+	uint32_t vertices;
+	vector<Edge> edges;				// Normalized, without self loops
+	vector<uint32_t> identity;		// Every vertex is its own label
+	vector<uint32_t> hooked;		// After one deterministic hook: the input of find_roots
+	vector<uint32_t> rooted;		// After the hook and find_roots: the input of the edge removal
+};
+
+struct BenchResult
+{
+	string kernel, graph;
+	int threads;
+	uint32_t vertices;
+	uint64_t edges;
+	int repetitions;
+	double min_time, median_time;	// Seconds
+};
+
+// Minimum time and repetitions of every measurement
+double min_time = 0.2;
+const int min_repetitions = 3;
+
+BenchGraph make_graph(const cc::GraphSpec& spec, const string& text)
+{
+	BenchGraph graph;
+	graph.spec = text;
+	graph.vertices = cc::generate_graph(spec, graph.edges);
+
+	// Same ingest as the cc driver: no self loops, from < to
+	size_t count = 0;
+	for (auto edge : graph.edges)
+	{
+		if (edge.from != edge.to)
+		{
+			edge.normalize();
+			graph.edges[count++] = edge;
+		}
+	}
+	graph.edges.resize(count);
+
+	graph.identity.resize(graph.vertices);
+	iota(graph.identity.begin(), graph.identity.end(), 0);
+
+	graph.hooked = graph.identity;
+	for (const Edge& edge : graph.edges)
+		graph.hooked[edge.from] = edge.to;
+
+	graph.rooted = graph.hooked;
+	cc::find_roots(graph.vertices, graph.rooted.data());
+
+	return graph;
+}
+
+// Repeat setup + kernel until min_time is spent, only the kernel is timed
+BenchResult measure(const string& kernel, const BenchGraph& graph, int threads, function<void()> setup, function<void()> run)
+{
+	omp_set_num_threads(threads);
+
+	vector<double> times;
+	double total = 0;
+	while (times.size() < (size_t)min_repetitions || total < min_time)
+	{
+		setup();
+		double start = omp_get_wtime();
+		run();
+		times.push_back(omp_get_wtime() - start);
+		total += times.back();
+	}
+
+	sort(times.begin(), times.end());
+	return {kernel, graph.spec, threads, graph.vertices, graph.edges.size(), (int)times.size(), times.front(), times[times.size() / 2]};
+}
+
+void print_result(const BenchResult& result)
+{
+	string str = result.kernel + " " + result.graph + " threads=" + to_string(result.threads)
+		+ " reps=" + to_string(result.repetitions)
+		+ " median=" + to_string(result.median_time) + " s"
+		+ " " + to_string(result.edges / result.median_time / 1e6) + " Medges/s"
+		+ " " + to_string(result.vertices / result.median_time / 1e6) + " Mvertices/s\n";
+	cout << str;
+}
+
+void write_json(const string& name, const vector<BenchResult>& results)
+{
+	time_t now = time(nullptr);
+	char date[32];
+	strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+	ofstream file(name);
+	file.precision(12);
+	file << "{\n  \"context\": {\n";
+	file << "    \"date\": \"" << date << "\",\n";
+	file << "    \"num_cpus\": " << omp_get_num_procs() << ",\n";
+	file << "    \"min_time\": " << min_time << "\n  },\n";
+	file << "  \"benchmarks\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchResult& result = results[i];
+		file << "    {\"name\": \"" << result.kernel << "/" << result.graph << "/threads:" << result.threads << "\", "
+			 << "\"run_type\": \"iteration\", \"iterations\": " << result.repetitions << ", "
+			 << "\"real_time\": " << result.median_time * 1e9 << ", \"min_time\": " << result.min_time * 1e9 << ", \"time_unit\": \"ns\", "
+			 << "\"threads\": " << result.threads << ", \"vertices\": " << result.vertices << ", \"edges\": " << result.edges << ", "
+			 << "\"edges_per_second\": " << result.edges / result.median_time << ", "
+			 << "\"vertices_per_second\": " << result.vertices / result.median_time << "}"
+			 << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	file << "  ]\n}\n";
+}
+
+// Split a comma separated list
+vector<string> split_list(const string& list)
+{
+	vector<string> items;
+	stringstream stream(list);
+	string item;
+	while (getline(stream, item, ','))
+		if (!item.empty())
+			items.push_back(item);
+	return items;
+}
+
+int main(int argc, char* argv[])
+{
+	//---------------------- Parse the options ----------------------
+
+	vector<string> specs = {"rmat:14:8", "rmat:16:8", "rmat:18:8"};
+	vector<int> thread_counts = {1};
+	if (omp_get_max_threads() > 1)
+		thread_counts.push_back(omp_get_max_threads());
+	string json_file, filter;
+	uint64_t seed = 17;
+
+	bool valid_options = true;
+	for (int i = 1; i < argc && valid_options; i++)
+	{
+		string option = argv[i];
+		if (option.compare(0, 9, "--graphs=") == 0)
+			specs = split_list(option.substr(9));
+		else if (option.compare(0, 10, "--threads=") == 0)
+		{
+			thread_counts.clear();
+			for (const string& count : split_list(option.substr(10)))
+				thread_counts.push_back(atoi(count.c_str()));
+			valid_options = !thread_counts.empty() && *min_element(thread_counts.begin(), thread_counts.end()) > 0;
+		}
+		else if (option.compare(0, 11, "--min-time=") == 0)
+			min_time = atof(option.c_str() + 11);
+		else if (option.compare(0, 9, "--filter=") == 0)
+			filter = option.substr(9);
+		else if (option.compare(0, 7, "--json=") == 0)
+			json_file = option.substr(7);
+		else if (option.compare(0, 7, "--seed=") == 0)
+			seed = strtoull(option.c_str() + 7, nullptr, 10);
+		else
+		{
+			cout << "Unknown option: " << option << endl;
+			valid_options = false;
+		}
+	}
+
+	vector<cc::GraphSpec> graph_specs(specs.size());
+	for (size_t i = 0; i < specs.size() && valid_options; i++)
+	{
+		valid_options = cc::parse_graph_spec(specs[i], graph_specs[i]);
+		graph_specs[i].seed = seed;
+		if (valid_options && cc::graph_edge_count(graph_specs[i]) > cc::MAX_EDGE_COUNT)
+		{
+			cout << specs[i] << " has " << cc::graph_edge_count(graph_specs[i]) << " edges, the kernels take at most " << cc::MAX_EDGE_COUNT << endl;
+			valid_options = false;
+		}
+	}
+
+	if (!valid_options)
+	{
+		cout << "Usage: bench [--graphs=SPEC,SPEC,...] [--threads=N,N,...] [--min-time=SECONDS] [--filter=KERNEL] [--json=FILE] [--seed=N]" << endl;
+		return 1;
+	}
+
+	//---------------------- Run the kernels ----------------------
+
+	// The kernels print nothing while they are measured
+	cc::verbose_iterations() = false;
+
+	vector<BenchResult> results;
+	auto record = [&](const BenchResult& result) { print_result(result); results.push_back(result); };
+	auto selected = [&](const string& kernel) { return kernel.find(filter) != string::npos; };
+
+	for (size_t g = 0; g < specs.size(); g++)
+	{
+		BenchGraph graph = make_graph(graph_specs[g], specs[g]);
+		vector<uint32_t> labels;
+		size_t sink = 0; // Keeps the results of the kernels alive
+
+		// Serial kernels: one thread
+		unique_ptr<DisjointSets<uint32_t>> sets;
+		if (selected("DisjointSets::unify"))
+			record(measure("DisjointSets::unify", graph, 1,
+				[&] { sets.reset(new DisjointSets<uint32_t>(max(graph.vertices, 1u))); },
+				[&] { for (const Edge& edge : graph.edges) sets->unify(edge.from, edge.to); }));
+		if (selected("DisjointSets::find"))
+			record(measure("DisjointSets::find", graph, 1,
+				[&] { sets.reset(new DisjointSets<uint32_t>(max(graph.vertices, 1u)));
+					  for (const Edge& edge : graph.edges) sets->unify(edge.from, edge.to); },
+				[&] { for (uint32_t v = 0; v < graph.vertices; v++) sink += sets->find(v); }));
+		sets.reset();
+
+		#ifdef CC_MPI
+		// Kernels of the MPI engine: every process runs them on its slice with one thread
+		if (selected("mpi::hook_nodes"))
+			record(measure("mpi::hook_nodes", graph, 1,
+				[&] { labels = graph.identity; },
+				[&] { hook_nodes(graph.edges, labels); }));
+		if (selected("mpi::find_roots"))
+			record(measure("mpi::find_roots", graph, 1,
+				[&] { labels = graph.hooked; },
+				[&] { ::find_roots(graph.vertices, labels); }));
+		if (selected("mpi::compute_next_edges"))
+			record(measure("mpi::compute_next_edges", graph, 1,
+				[&] {},
+				[&] { sink += compute_next_edges(graph.edges, graph.rooted).size(); }));
+		#endif
+
+		// OpenMP kernels: every thread count. The buffers persist between the repetitions, as in cc::Context
+		cc::RoundBuffers buffers;
+		vector<Edge> next_edges;
+		for (int threads : thread_counts)
+		{
+			if (selected("coin_toss_and_child_hook"))
+			{
+				omp_set_num_threads(threads);
+				cc::configure_RNG();
+				record(measure("coin_toss_and_child_hook", graph, threads,
+					[&] { labels = graph.identity; },
+					[&] { cc::coin_toss_and_child_hook(graph.vertices, graph.edges, labels.data(), buffers); }));
+			}
+			if (selected("find_roots"))
+				record(measure("find_roots", graph, threads,
+					[&] { labels = graph.hooked; },
+					[&] { cc::find_roots(graph.vertices, labels.data()); }));
+			if (selected("find_rank_and_remove_edges"))
+				record(measure("find_rank_and_remove_edges", graph, threads,
+					[&] { labels = graph.rooted; },
+					[&] { cc::find_rank_and_remove_edges(graph.vertices, graph.edges, labels.data(), buffers, next_edges); sink += next_edges.size(); }));
+		}
+
+		if (sink == 1)
+			cout << endl;
+	}
+
+	if (!json_file.empty())
+		write_json(json_file, results);
+
+	return 0;
+}
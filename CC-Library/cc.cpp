@@ -0,0 +1,275 @@
+#ifdef CC_MPI
+#include <mpi.h>
+#endif
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <string>
+#include <unordered_set>
+#include <fstream>
+//POSIX headers
+#include <sys/resource.h>
+//Custom libraries
+#ifdef CC_INSTRUMENT
+// The report counts the allocations of every phase: this program replaces operator new and delete
+#define CC_ALLOCATION_HOOKS
+#endif
+#include "cc/Edge.hpp"
+#include "cc/GraphInputIterator.hpp"
+#include "cc/Engines.hpp"
+#include "cc/GraphFiles.hpp"
+#include "cc/Generators.hpp"
+#include "cc/Instrumentation.hpp"
+#include "cc/Relabel.hpp"
+
+using namespace std;
+
+// Unified driver: every engine shares the same ingest, the same timing boundaries and the same output.
+// The timer starts when the root holds the edges and stops when it holds the labels: the distribution
+// of the edges by the distributed engines is timed, the reading of the file is not
+int main(int argc, char* argv[])
+{
+	//---------------------- Parse the options ----------------------
+
+	cc::Engine engine = cc::Engine::SERIAL;
+	// INPUT_FILE can also be gen:SPEC: the graph is generated in memory
+	cc::GraphSpec spec;
+	// JSON report of the rounds and Chrome trace of the phases (builds with make INSTRUMENT=1)
+	string report_file, trace_file;
+	// Hardware counters of every phase in the report
+	bool count_events = false;
+	// Renumbering of the vertices before the engine, timed apart
+	cc::VertexOrder vertex_order = cc::VertexOrder::NONE;
+	string input_name = argc >= 2 ? argv[1] : "";
+	bool generated = input_name.compare(0, 4, "gen:") == 0;
+	bool valid_options = argc >= 2 && (!generated || cc::parse_graph_spec(input_name.substr(4), spec));
+	for (int i = 2; i < argc && valid_options; i++)
+	{
+		string option = argv[i];
+		if (option.compare(0, 9, "--engine=") == 0)
+		{
+			valid_options = cc::parse_engine(option.substr(9), engine);
+			if (valid_options && !cc::engine_available(engine))
+			{
+				cout << "The " << cc::engine_name(engine) << " engine needs the MPI build (cc_mpi.out)" << endl;
+				valid_options = false;
+			}
+		}
+		else if (option.compare(0, 10, "--threads=") == 0 && atoi(option.c_str() + 10) > 0)
+			omp_set_num_threads(atoi(option.c_str() + 10));
+		else if (option.compare(0, 7, "--seed=") == 0)
+			spec.seed = strtoull(option.c_str() + 7, nullptr, 10);
+		else if (option.compare(0, 9, "--report=") == 0)
+		{
+			report_file = option.substr(9);
+			#ifndef CC_INSTRUMENT
+			cout << "--report needs the instrumented build (make INSTRUMENT=1)" << endl;
+			valid_options = false;
+			#endif
+		}
+		else if (option.compare(0, 8, "--trace=") == 0)
+		{
+			trace_file = option.substr(8);
+			#ifndef CC_INSTRUMENT
+			cout << "--trace needs the instrumented build (make INSTRUMENT=1)" << endl;
+			valid_options = false;
+			#endif
+		}
+		else if (option.compare(0, 10, "--relabel=") == 0)
+			valid_options = cc::parse_vertex_order(option.substr(10), vertex_order);
+		else if (option == "--counters")
+		{
+			count_events = true;
+			#ifndef CC_INSTRUMENT
+			cout << "--counters needs the instrumented build (make INSTRUMENT=1)" << endl;
+			valid_options = false;
+			#endif
+		}
+		else
+		{
+			cout << "Unknown option: " << option << endl;
+			valid_options = false;
+		}
+	}
+
+	if (valid_options && generated && cc::graph_edge_count(spec) > cc::MAX_EDGE_COUNT)
+	{
+		cout << input_name << " has " << cc::graph_edge_count(spec) << " edges, the engines take at most " << cc::MAX_EDGE_COUNT << endl;
+		valid_options = false;
+	}
+
+	if (!valid_options)
+	{
+		cout << "Usage: cc INPUT_FILE|gen:SPEC [--engine=serial|omp-det|omp-rand|mpi|ppopp] [--threads=N] [--seed=N] [--relabel=none|degree|bfs|rcm] [--report=FILE [--counters]] [--trace=FILE]" << endl;
+		cout << "--seed: seed of the gen: graphs and of the sampling of the ppopp engine" << endl;
+		cout << "SPEC: rmat:SCALE:DEGREE | er:N:M | grid2d:X:Y | grid3d:X:Y:Z | path:N | islands:COUNT:SIZE" << endl;
+		return 1;
+	}
+
+	int32_t group_size = 1, rank = 0;
+	#ifdef CC_MPI
+	MPI_Init(&argc, &(argv));
+	MPI_Comm_size(MPI_COMM_WORLD, &group_size);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	#endif
+
+	//---------------------- Read the graph ----------------------
+
+	double read_start_time = omp_get_wtime();
+	uint32_t nNodes = 0, real_edge_count = 0;
+	vector<Edge> edges;
+	if (rank == 0)
+	{
+		//Generate the graph, or read the number of vertices and the edges from the file
+		if (generated)
+			nNodes = cc::generate_graph(spec, edges);
+		else if (cc::binary_graph_file(input_name))
+			nNodes = cc::read_binary_graph(input_name, edges);
+		else
+		{
+			GraphInputIterator input(input_name);
+			nNodes = input.vertexCount();
+			edges.reserve(input.edgeCount());
+			for (auto edge : input)
+				edges.push_back(edge);
+		}
+		size_t input_edge_count = edges.size();
+
+		//Remove the self loops in place
+		for (auto edge : edges)
+		{
+			//Check that the edge is valid i.e. the nodes are in the graph
+			assert(edge.from < nNodes);
+			assert(edge.to < nNodes);
+			//Check that the edge is not a self loop
+			if (edge.to != edge.from)
+			{
+				//Normalize the edge so that from < to
+				edge.normalize();
+				edges[real_edge_count++] = edge;
+			}
+		}
+		edges.resize(real_edge_count);
+
+		//Check if self loops were removed
+		if (real_edge_count != input_edge_count)
+			cout << "Warning: " << input_edge_count - real_edge_count << " self loops were removed" << endl;
+	}
+
+	double read_time = omp_get_wtime() - read_start_time;
+
+	// The root renumbers the vertices of its edges, the labels are mapped back after the engine
+	double relabel_start_time = omp_get_wtime();
+	vector<uint32_t> vertex_order_map;
+	if (rank == 0 && vertex_order != cc::VertexOrder::NONE)
+		vertex_order_map = cc::relabel_graph(vertex_order, nNodes, edges);
+	double relabel_time = omp_get_wtime() - relabel_start_time;
+
+	//---------------------- Compute CC ----------------------
+
+	#ifdef CC_MPI
+	MPI_Bcast(&nNodes, 1, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+	MPI_Bcast(&real_edge_count, 1, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+	MPI_Barrier(MPI_COMM_WORLD);
+	#endif
+
+	vector<uint32_t> labels;
+	int iterations = 0;
+	cc::Instrumentation::instance().reset(cc::engine_name(engine));
+	if (!trace_file.empty())
+		cc::Tracer::instance().enable();
+	// Without permission or without PMU the run goes on, the report lists the missing counters
+	if (count_events && !cc::PerfCounters::instance().enable() && rank == 0)
+		cout << "Warning: no hardware counter available (" << cc::PerfCounters::instance().reason(0) << ")" << endl;
+	double start_time = omp_get_wtime();
+	if (rank == 0 || cc::distributed_engine(engine))
+		iterations = cc::run_engine(engine, nNodes, real_edge_count, edges, labels, spec.seed);
+	double elapsed_time = omp_get_wtime() - start_time;
+
+	relabel_start_time = omp_get_wtime();
+	if (rank == 0 && vertex_order != cc::VertexOrder::NONE)
+		cc::restore_labels(labels, vertex_order_map);
+	relabel_time += omp_get_wtime() - relabel_start_time;
+
+	// The distributed engines reduce the rounds of all the processes on the root
+	if (!report_file.empty())
+	{
+		// Only the root writes the report
+		ofstream report;
+		if (rank == 0)
+			report.open(report_file);
+		#ifdef CC_MPI
+		if (cc::distributed_engine(engine))
+			cc::write_instrumentation_report(report, MPI_COMM_WORLD);
+		else
+		#endif
+		if (rank == 0)
+			cc::Instrumentation::instance().writeJson(report);
+	}
+
+	// Open with chrome://tracing or ui.perfetto.dev
+	if (!trace_file.empty())
+	{
+		cc::Tracer::instance().disable();
+		if (cc::Tracer::instance().dropped() > 0)
+			cout << "Warning: " << cc::Tracer::instance().dropped() << " trace events did not fit in the buffers of rank " << rank << endl;
+		ofstream trace;
+		if (rank == 0)
+			trace.open(trace_file);
+		#ifdef CC_MPI
+		cc::write_trace(trace, MPI_COMM_WORLD);
+		#else
+		cc::Tracer::instance().writeJson(trace);
+		#endif
+	}
+
+	// Peak resident memory of the biggest process (ru_maxrss is in KB on Linux)
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	long peak_memory = usage.ru_maxrss;
+	#ifdef CC_MPI
+	long local_peak_memory = peak_memory;
+	MPI_Reduce(&local_peak_memory, &peak_memory, 1, MPI_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+	#endif
+
+	//---------------------- Print the results ----------------------
+
+	if (rank == 0)
+	{
+		//Count the number of connected components
+		uint32_t number_of_cc = unordered_set<uint32_t>(labels.begin(), labels.end()).size();
+
+		cout << fixed;
+		cout << "------------------------------------------------" << endl;
+		cout << "Engine: " << cc::engine_name(engine) << endl;
+		cout << "File Name: " << argv[1] << endl;
+		if (generated || engine == cc::Engine::PPOPP)
+			cout << "Seed: " << spec.seed << endl;
+		cout << "Group Size: " << (cc::distributed_engine(engine) ? group_size : 1) << endl;
+		cout << "Threads: " << omp_get_max_threads() << endl;
+		cout << "Number of vertices: " << nNodes << endl;
+		cout << "Number of edges: " << real_edge_count << endl;
+		cout << "Iterations: " << iterations << endl;
+		cout << "Number of connected components: " << number_of_cc << endl;
+		cout << "Read time: " << read_time << " seconds" << endl;
+		cout << "Elapsed time: " << elapsed_time << " seconds" << endl;
+		if (vertex_order != cc::VertexOrder::NONE)
+		{
+			// The relabeling pays off when the total is below the elapsed time without it
+			cout << "Relabel: " << cc::vertex_order_name(vertex_order) << endl;
+			cout << "Relabel time: " << relabel_time << " seconds" << endl;
+			cout << "Total time: " << relabel_time + elapsed_time << " seconds" << endl;
+		}
+		cout << "Peak memory: " << peak_memory / 1024.0 << " MB" << endl;
+	}
+
+	#ifdef CC_MPI
+	MPI_Finalize();
+	#endif
+
+	return 0;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <cstdint>
+//Custom libraries
+#include "Edge.hpp"
+#include "EdgeSpan.hpp"
+#include "Engines.hpp"
+
+using namespace std;
+
+/*
+ * Embeddable API: the labels of the components of a graph whose edges live in the memory of the caller.
+ *
+ *	cc::Context context;
+ *	cc::Options options;
+ *	options.threads = 8;
+ *	context.components(cc::EdgeSpan(edges, edge_count), vertex_count, labels, options);
+ *
+ * The edges are read in place, in any orientation, and the engines compute the labels directly in the array of
+ * the caller. A Context keeps the buffers of the rounds (the edges of the next rounds, the prefix sums, the coin
+ * tosses) between the calls and only grows them: labelling the same graph again allocates nothing. The randomized
+ * engine on several threads is the exception: its rounds depend on the order of the concurrent hooks, a round
+ * bigger than in the previous calls grows its buffer (the deterministic engine sizes its two buffers for the
+ * edges of the call).
+ * A Context must not be shared by concurrent calls.
+ */
+namespace cc
+{
+
+struct Options
+{
+	Engine engine = Engine::OMP_DETERMINISTIC;	// Only the shared-memory engines: see engine_available and distributed_engine
+	int threads = 0;							// OpenMP threads for this call (0: the current default)
+	bool verbose = false;						// Print the number of edges of every iteration
+};
+
+class Context
+{
+	RoundBuffers buffers_;		// Buffers of the rounds, grown by the calls that need more
+
+public:
+	int iterations_ = 0;		// Iterations of the last call
+
+	/**
+	 * Label every vertex with the representative of its component
+	 * @param edges edges of the caller, every endpoint smaller than vertex_count. Not modified
+	 * @param [out] labels array of vertex_count labels owned by the caller
+	 * @return false if the engine cannot run in a shared-memory call (distributed or not compiled)
+	 */
+	bool components(EdgeSpan edges, uint32_t vertex_count, uint32_t* labels, const Options& options = Options())
+	{
+		if (distributed_engine(options.engine) || !engine_available(options.engine))
+			return false;
+
+		// The settings of the caller are restored before returning
+		int previous_threads = omp_get_max_threads();
+		if (options.threads > 0)
+			omp_set_num_threads(options.threads);
+		bool previous_verbose = verbose_iterations();
+		verbose_iterations() = options.verbose;
+
+		#pragma omp parallel for
+		for (uint32_t i = 0; i < vertex_count; i++)
+			labels[i] = i;
+
+		iterations_ = 0;
+		switch (options.engine)
+		{
+		case Engine::SERIAL:
+			iterations_ = serial_cc(vertex_count, edges, labels, buffers_);
+			break;
+		case Engine::OMP_DETERMINISTIC:
+			par_deterministic_cc(vertex_count, edges, labels, &iterations_, buffers_);
+			break;
+		case Engine::OMP_RANDOMIZED:
+			configure_RNG();
+			par_randomized_cc(vertex_count, edges, labels, &iterations_, buffers_);
+			break;
+		default:
+			break;
+		}
+
+		verbose_iterations() = previous_verbose;
+		omp_set_num_threads(previous_threads);
+		return true;
+	}
+
+	// Give the buffers of the rounds back to the allocator
+	void release() { buffers_ = RoundBuffers(); }
+};
+
+// One-shot call: the buffers are freed before returning
+inline bool components(EdgeSpan edges, uint32_t vertex_count, uint32_t* labels, const Options& options = Options())
+{
+	Context context;
+	return context.components(edges, vertex_count, labels, options);
+}
+
+} // namespace cc
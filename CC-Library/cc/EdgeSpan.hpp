@@ -0,0 +1,32 @@
+#pragma once
+
+//Standard libraries
+#include <vector>
+#include <cstddef>
+//Custom libraries
+#include "Edge.hpp"
+
+using namespace std;
+
+namespace cc
+{
+
+// Read-only view of an array of edges owned by the caller (std::span<const Edge> is C++20).
+// The engines take it instead of a vector: a vector converts implicitly, an array is read in place
+class EdgeSpan
+{
+	const Edge* data_;
+	size_t size_;
+
+public:
+	EdgeSpan(const Edge* data, size_t size) : data_(data), size_(size) {}
+	EdgeSpan(const vector<Edge>& edges) : data_(edges.data()), size_(edges.size()) {}
+
+	const Edge* data() const { return data_; }
+	size_t size() const { return size_; }
+	const Edge& operator[](size_t i) const { return data_[i]; }
+	const Edge* begin() const { return data_; }
+	const Edge* end() const { return data_ + size_; }
+};
+
+} // namespace cc
@@ -0,0 +1,199 @@
+#pragma once
+
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <vector>
+#include <string>
+#include <cstdint>
+//Custom libraries
+#include "Edge.hpp"
+#include "EdgeSpan.hpp"
+#include "DisjointSets.hpp"
+#include "OpenMPEngines.hpp"
+#include "Instrumentation.hpp"
+
+// The distributed engines are only built in the MPI variant of the library
+#ifdef CC_MPI
+#include <mpi.h>
+#include "MPIEdge.hpp"
+#include "MPIInstrumentation.hpp"
+#include "../../CSE613-MPI/utils/mpi_parallel_cc.hpp"
+#include "../../PPoPP_2018/utils/SparseSampling.hpp"
+#endif
+
+using namespace std;
+
+namespace cc
+{
+
+// Connected components implementations of the projects
+enum class Engine
+{
+	SERIAL,				// Union-find (Serial)
+	OMP_DETERMINISTIC,	// Deterministic hooking and pointer jumping (CSE613-OpenMP)
+	OMP_RANDOMIZED,		// Randomized hooking (CSE613-OpenMP)
+	MPI,				// Master and slaves (CSE613-MPI)
+	PPOPP				// Sparse sampling (PPoPP_2018)
+};
+
+// Name of the engine on the command line
+inline const char* engine_name(Engine engine)
+{
+	switch (engine)
+	{
+	case Engine::SERIAL: return "serial";
+	case Engine::OMP_DETERMINISTIC: return "omp-det";
+	case Engine::OMP_RANDOMIZED: return "omp-rand";
+	case Engine::MPI: return "mpi";
+	case Engine::PPOPP: return "ppopp";
+	}
+	return "unknown";
+}
+
+// Returns false if the name is not an engine
+inline bool parse_engine(const string& name, Engine& engine)
+{
+	for (Engine candidate : {Engine::SERIAL, Engine::OMP_DETERMINISTIC, Engine::OMP_RANDOMIZED, Engine::MPI, Engine::PPOPP})
+	{
+		if (name == engine_name(candidate))
+		{
+			engine = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+// The distributed engines run on all the processes, the others on the root only
+inline bool distributed_engine(Engine engine)
+{
+	return engine == Engine::MPI || engine == Engine::PPOPP;
+}
+
+// Returns false if the engine needs MPI and the library was built without it
+inline bool engine_available(Engine engine)
+{
+	#ifdef CC_MPI
+	return true;
+	#else
+	return !distributed_engine(engine);
+	#endif
+}
+
+// Union-find: every vertex is labelled with the representative of its set
+inline int serial_cc(uint32_t nNodes, EdgeSpan edges, uint32_t* labels, RoundBuffers& buffers)
+{
+	// The union-find needs at least one element
+	if (nNodes == 0)
+		return 1;
+
+	CC_ROUND(edges.size(), nNodes);
+	// The labels of the caller are the parents of the union-find, the ranks are in the buffers
+	unsigned* ranks = reuse(buffers.ranks, nNodes);
+	for (uint32_t i = 0; i < nNodes; i++)
+	{
+		ranks[i] = 0;
+		labels[i] = i;
+	}
+	boost::disjoint_sets<unsigned*, uint32_t*> disjoint_set(ranks, labels);
+
+	// Unify the vertices of each edge
+	{
+		CC_PHASE(HOOK);
+		for (auto edge : edges)
+			disjoint_set.link(edge.from, edge.to);
+	}
+
+	{
+		CC_PHASE(FIND_ROOTS);
+		for (uint32_t i = 0; i < nNodes; i++)
+			labels[i] = disjoint_set.find_set(i);
+	}
+
+	return 1;
+}
+
+inline int serial_cc(uint32_t nNodes, EdgeSpan edges, uint32_t* labels)
+{
+	RoundBuffers buffers;
+	return serial_cc(nNodes, edges, labels, buffers);
+}
+
+#ifdef CC_MPI
+// Master and slaves with the default options. Collective call: edges are only read on the root
+inline int mpi_cc(uint32_t nNodes, vector<Edge>& edges, vector<uint32_t>& labels)
+{
+	int32_t group_size, rank;
+	MPI_Comm_size(MPI_COMM_WORLD, &group_size);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPIEdge::constructType();
+
+	CCOptions options;
+	PhaseWaitTimes times;
+	int iteration = 0;
+	if (rank == 0)
+		master(rank, group_size, nNodes, edges.size(), edges, labels, &iteration, options, nullptr, nullptr, times);
+	else
+		slave(rank, group_size, nNodes, options, nullptr, nullptr, times);
+
+	return iteration;
+}
+
+// Sparse sampling down to one vertex per component. Collective call: edges are only read on the root
+inline int ppopp_cc(uint32_t nNodes, uint32_t nEdges, const vector<Edge>& edges, vector<uint32_t>& labels, int32_t seed = 17)
+{
+	int32_t group_size, rank;
+	MPI_Comm_size(MPI_COMM_WORLD, &group_size);
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+	SparseSampling sampler(MPI_COMM_WORLD, group_size, rank, seed + rank, 1, nNodes, nEdges);
+	sampler.scatterSlice(edges);
+	sampler.connectedComponents(labels);
+
+	return sampler.rounds_;
+}
+#endif
+
+/**
+ * Compute the connected components with one of the engines
+ * @param nNodes number of vertices, known by every process
+ * @param edges edges without self loops, normalized (from < to). Only read on the root by the distributed engines
+ * @param [out] labels label of the component of every vertex (on the root), resized to nNodes
+ * @param seed seed of the sampling of the ppopp engine (the other engines are deterministic or seeded per thread)
+ * @return the number of iterations (rounds) of the engine
+ */
+inline int run_engine(Engine engine, uint32_t nNodes, uint32_t nEdges, vector<Edge>& edges, vector<uint32_t>& labels, int32_t seed = 17)
+{
+	labels.resize(nNodes);
+	for (uint32_t i = 0; i < nNodes; i++)
+		labels[i] = i;
+
+	int iteration = 0;
+	switch (engine)
+	{
+	case Engine::SERIAL:
+		return serial_cc(nNodes, edges, labels.data());
+	case Engine::OMP_DETERMINISTIC:
+		par_deterministic_cc(nNodes, edges, labels.data(), &iteration);
+		return iteration;
+	case Engine::OMP_RANDOMIZED:
+		configure_RNG();
+		// The recursion returns the labels themselves
+		par_randomized_cc(nNodes, edges, labels.data(), &iteration);
+		return iteration;
+	#ifdef CC_MPI
+	case Engine::MPI:
+		return mpi_cc(nNodes, edges, labels);
+	case Engine::PPOPP:
+		return ppopp_cc(nNodes, nEdges, edges, labels, seed);
+	#else
+	default:
+		break;
+	#endif
+	}
+
+	return iteration;
+}
+
+} // namespace cc
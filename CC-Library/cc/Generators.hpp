@@ -0,0 +1,261 @@
+#pragma once
+
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+//Custom libraries
+#include "Edge.hpp"
+
+using namespace std;
+
+/*
+ * Synthetic graphs for the scaling studies, described by a spec string:
+ *	rmat:SCALE:DEGREE		R-MAT (Graph500 probabilities), 2^SCALE vertices and DEGREE * 2^SCALE edges, labels scrambled
+ *	er:N:M					Erdos-Renyi G(N, M): M edges with uniform endpoints (self loops and duplicates are possible)
+ *	grid2d:X:Y				X * Y grid, one component
+ *	grid3d:X:Y:Z			X * Y * Z grid, one component
+ *	path:N					Path 0 - 1 - ... - N-1: the longest chains for pointer jumping
+ *	islands:COUNT:SIZE		COUNT random trees of SIZE vertices
+ *
+ * Every edge is a function of (seed, edge index) only, so the graph is the same for any number of threads
+ * and the edges are written in parallel directly in the destination array.
+ */
+namespace cc
+{
+
+enum class GraphKind
+{
+	RMAT,
+	ERDOS_RENYI,
+	GRID,		// grid2d and path are grids with Z = 1 (and Y = 1)
+	ISLANDS
+};
+
+struct GraphSpec
+{
+	GraphKind kind = GraphKind::GRID;
+	uint64_t sizes[3] = {1, 1, 1};
+	uint64_t seed = 17;
+};
+
+// Counter-based generator (SplitMix64): the stream of an edge only depends on the seed and the edge index
+class CounterRNG
+{
+	uint64_t state_;
+
+	static uint64_t mix(uint64_t x)
+	{
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+		return x ^ (x >> 31);
+	}
+
+public:
+	CounterRNG(uint64_t seed, uint64_t counter) : state_(seed ^ mix(counter + 0x9E3779B97F4A7C15)) {}
+
+	uint64_t next()
+	{
+		state_ += 0x9E3779B97F4A7C15;
+		return mix(state_);
+	}
+
+	// Multiply-shift to [0, bound), bound <= 2^32
+	uint32_t bounded(uint64_t bound) { return uint32_t(((next() >> 32) * bound) >> 32); }
+
+	// Uniform in [0, 1)
+	double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+};
+
+/**
+ * Parse a spec like "rmat:20:16"
+ * @return false if the spec is malformed or the graph has 2^32 vertices or more
+ */
+inline bool parse_graph_spec(const string& text, GraphSpec& spec)
+{
+	size_t colon = text.find(':');
+	string kind = text.substr(0, colon);
+
+	vector<uint64_t> sizes;
+	while (colon != string::npos)
+	{
+		size_t next = text.find(':', colon + 1);
+		string size = text.substr(colon + 1, next == string::npos ? string::npos : next - colon - 1);
+		if (size.empty() || size.find_first_not_of("0123456789") != string::npos)
+			return false;
+		sizes.push_back(strtoull(size.c_str(), nullptr, 10));
+		colon = next;
+	}
+
+	size_t expected_sizes;
+	if (kind == "rmat")
+		spec.kind = GraphKind::RMAT, expected_sizes = 2;
+	else if (kind == "er")
+		spec.kind = GraphKind::ERDOS_RENYI, expected_sizes = 2;
+	else if (kind == "grid2d")
+		spec.kind = GraphKind::GRID, expected_sizes = 2;
+	else if (kind == "grid3d")
+		spec.kind = GraphKind::GRID, expected_sizes = 3;
+	else if (kind == "path")
+		spec.kind = GraphKind::GRID, expected_sizes = 1;
+	else if (kind == "islands")
+		spec.kind = GraphKind::ISLANDS, expected_sizes = 2;
+	else
+		return false;
+
+	if (sizes.size() != expected_sizes)
+		return false;
+	for (size_t i = 0; i < 3; i++)
+		spec.sizes[i] = i < sizes.size() ? sizes[i] : 1;
+
+	if (spec.kind == GraphKind::RMAT && (spec.sizes[0] > 31 || spec.sizes[1] == 0))
+		return false;
+	for (size_t i = 0; i < 3; i++)
+		if (spec.sizes[i] == 0 || spec.sizes[i] > UINT32_MAX)
+			return false;
+
+	// Every size is below 2^32, so each product fits before the check
+	if (spec.kind == GraphKind::GRID || spec.kind == GraphKind::ISLANDS)
+		return spec.sizes[0] * spec.sizes[1] <= UINT32_MAX && spec.sizes[0] * spec.sizes[1] * spec.sizes[2] <= UINT32_MAX;
+	return true;
+}
+
+// The engines count and index the edges with uint32_t: the bigger graphs are rejected by the drivers
+const uint64_t MAX_EDGE_COUNT = UINT32_MAX;
+
+inline uint32_t graph_vertex_count(const GraphSpec& spec)
+{
+	switch (spec.kind)
+	{
+	case GraphKind::RMAT:
+		return uint32_t(1) << spec.sizes[0];
+	case GraphKind::ERDOS_RENYI:
+		return spec.sizes[0];
+	default:
+		return spec.sizes[0] * spec.sizes[1] * spec.sizes[2];
+	}
+}
+
+inline uint64_t graph_edge_count(const GraphSpec& spec)
+{
+	const uint64_t x = spec.sizes[0], y = spec.sizes[1], z = spec.sizes[2];
+	switch (spec.kind)
+	{
+	case GraphKind::RMAT:
+		return spec.sizes[1] << spec.sizes[0];
+	case GraphKind::ERDOS_RENYI:
+		return spec.sizes[1];
+	case GraphKind::GRID:
+		return (x - 1) * y * z + x * (y - 1) * z + x * y * (z - 1);
+	case GraphKind::ISLANDS:
+		return x * (y - 1);
+	}
+	return 0;
+}
+
+// Bijection of [0, 2^scale): the R-MAT hubs are not the smallest labels
+inline uint32_t scramble(uint32_t vertex, uint32_t scale, uint64_t seed)
+{
+	const uint64_t mask = (uint64_t(1) << scale) - 1;
+	uint64_t x = vertex;
+	for (int round = 0; round < 2; round++)
+	{
+		// Multiplication by an odd number and xor with a right shift are invertible modulo 2^scale
+		x = (x * ((seed >> (32 * round)) | 1)) & mask;
+		x ^= x >> (scale / 2 + 1);
+	}
+	return x;
+}
+
+/**
+ * Generate the edges of the spec
+ * @param [out] edges array of graph_edge_count(spec) edges
+ */
+inline void generate_graph(const GraphSpec& spec, Edge* edges)
+{
+	const uint64_t x = spec.sizes[0], y = spec.sizes[1], z = spec.sizes[2];
+	const uint64_t edge_count = graph_edge_count(spec);
+
+	switch (spec.kind)
+	{
+	case GraphKind::RMAT:
+	{
+		// Graph500 quadrant probabilities: a = 0.57, b = 0.19, c = 0.19, d = 0.05
+		const double a = 0.57, ab = 0.76, abc = 0.95;
+		const uint32_t scale = x;
+		const uint64_t scramble_seed = CounterRNG(spec.seed, UINT64_MAX).next();
+
+		#pragma omp parallel for
+		for (uint64_t i = 0; i < edge_count; i++)
+		{
+			CounterRNG rng(spec.seed, i);
+			uint32_t from = 0, to = 0;
+			for (uint32_t bit = 0; bit < scale; bit++)
+			{
+				double r = rng.uniform();
+				from = (from << 1) | (r >= ab);
+				to = (to << 1) | ((r >= a && r < ab) || r >= abc);
+			}
+			edges[i] = {scramble(from, scale, scramble_seed), scramble(to, scale, scramble_seed)};
+		}
+		break;
+	}
+	case GraphKind::ERDOS_RENYI:
+	{
+		#pragma omp parallel for
+		for (uint64_t i = 0; i < edge_count; i++)
+		{
+			CounterRNG rng(spec.seed, i);
+			uint32_t from = rng.bounded(x);
+			edges[i] = {from, rng.bounded(x)};
+		}
+		break;
+	}
+	case GraphKind::GRID:
+	{
+		// The edges along x, then along y, then along z, each block in vertex order
+		const uint64_t y_edges = (x - 1) * y * z, z_edges = y_edges + x * (y - 1) * z;
+
+		#pragma omp parallel for
+		for (uint64_t v = 0; v < x * y * z; v++)
+		{
+			uint64_t i = v % x, j = (v / x) % y, k = v / (x * y);
+			if (i + 1 < x)
+				edges[(k * y + j) * (x - 1) + i] = {uint32_t(v), uint32_t(v + 1)};
+			if (j + 1 < y)
+				edges[y_edges + (k * (y - 1) + j) * x + i] = {uint32_t(v), uint32_t(v + x)};
+			if (k + 1 < z)
+				edges[z_edges + v] = {uint32_t(v), uint32_t(v + x * y)};
+		}
+		break;
+	}
+	case GraphKind::ISLANDS:
+	{
+		// Random recursive tree: every vertex but the first of its island hooks to an earlier vertex of the island
+		#pragma omp parallel for
+		for (uint64_t v = 0; v < x * y; v++)
+		{
+			uint64_t island = v / y, j = v % y;
+			if (j > 0)
+			{
+				CounterRNG rng(spec.seed, v);
+				edges[v - island - 1] = {uint32_t(island * y + rng.bounded(j)), uint32_t(v)};
+			}
+		}
+		break;
+	}
+	}
+}
+
+// Returns the number of vertices
+inline uint32_t generate_graph(const GraphSpec& spec, vector<Edge>& edges)
+{
+	edges.resize(graph_edge_count(spec));
+	generate_graph(spec, edges.data());
+	return graph_vertex_count(spec);
+}
+
+} // namespace cc
@@ -0,0 +1,115 @@
+#pragma once
+
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+//Custom libraries
+#include "Edge.hpp"
+#include "EdgeSpan.hpp"
+
+using namespace std;
+
+/*
+ * Graph files besides the text format of GraphInputIterator ("VERTICES EDGES" then one "FROM TO" per line).
+ * The binary format is a header of three uint64_t (BINARY_GRAPH_MAGIC, vertices, edges) followed by the
+ * edges as pairs of uint32_t, in the byte order of the machine: it is read with one read call.
+ */
+namespace cc
+{
+
+const uint64_t BINARY_GRAPH_MAGIC = 0x3148504152474343; // "CCGRAPH1"
+
+// Files ending in .bin are binary
+inline bool binary_graph_file(const string& name)
+{
+	return name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0;
+}
+
+inline void write_binary_graph(const string& name, uint32_t vertex_count, EdgeSpan edges)
+{
+	ofstream file(name, ios::out | ios::binary);
+	file.exceptions(ofstream::failbit | ofstream::badbit);
+
+	uint64_t header[3] = {BINARY_GRAPH_MAGIC, vertex_count, edges.size()};
+	file.write(reinterpret_cast<const char*>(header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(edges.data()), edges.size() * sizeof(Edge));
+}
+
+// Returns the number of vertices. Throws runtime_error if the file is not a binary graph
+inline uint32_t read_binary_graph(const string& name, vector<Edge>& edges)
+{
+	ifstream file(name, ios::in | ios::binary);
+	file.exceptions(ifstream::failbit | ifstream::badbit);
+
+	uint64_t header[3];
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+	if (header[0] != BINARY_GRAPH_MAGIC || header[1] > UINT32_MAX)
+		throw runtime_error(name + " is not a binary graph file");
+	// The engines index the edges with uint32_t
+	if (header[2] > UINT32_MAX)
+		throw runtime_error(name + " has " + to_string(header[2]) + " edges, more than the 4294967295 of the engines");
+
+	edges.resize(header[2]);
+	file.read(reinterpret_cast<char*>(edges.data()), edges.size() * sizeof(Edge));
+	return header[1];
+}
+
+// Append the decimal digits of value
+inline void append_decimal(string& text, uint32_t value)
+{
+	char digits[10];
+	int length = 0;
+	do
+	{
+		digits[length++] = '0' + value % 10;
+		value /= 10;
+	} while (value > 0);
+
+	while (length > 0)
+		text += digits[--length];
+}
+
+// The edges are formatted by all the threads, one batch at a time, and written in order
+inline void write_text_graph(const string& name, uint32_t vertex_count, EdgeSpan edges)
+{
+	ofstream file(name, ios::out);
+	file.exceptions(ofstream::failbit | ofstream::badbit);
+	file << vertex_count << " " << edges.size() << "\n";
+
+	const size_t batch = size_t(1) << 22;
+	vector<string> texts(omp_get_max_threads());
+	for (size_t batch_from = 0; batch_from < edges.size(); batch_from += batch)
+	{
+		size_t batch_to = min(edges.size(), batch_from + batch);
+		for (auto& text : texts)
+			text.clear();
+
+		#pragma omp parallel
+		{
+			int thread = omp_get_thread_num(), threads = omp_get_num_threads();
+			// Contiguous block of the batch for this thread, so the blocks are written in thread order
+			size_t from = batch_from + (batch_to - batch_from) * thread / threads;
+			size_t to = batch_from + (batch_to - batch_from) * (thread + 1) / threads;
+
+			string& text = texts[thread];
+			for (size_t i = from; i < to; i++)
+			{
+				append_decimal(text, edges[i].from);
+				text += ' ';
+				append_decimal(text, edges[i].to);
+				text += '\n';
+			}
+		}
+
+		for (auto& text : texts)
+			file.write(text.data(), text.size());
+	}
+}
+
+} // namespace cc
@@ -0,0 +1,458 @@
+#pragma once
+
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <atomic>
+#include <cstdio>
+#include <algorithm>
+//Custom libraries
+#include "PerfCounters.hpp"
+#include "MemoryTracker.hpp"
+
+using namespace std;
+
+/*
+ * Per-round instrumentation of the engines, compiled in with -DCC_INSTRUMENT (make INSTRUMENT=1 in CC-Library).
+ * Without it the macros expand to nothing: their arguments are not even evaluated.
+ *
+ *	CC_ROUND(edges, vertices)		start a round with the edges and the vertices (roots) still alive
+ *	CC_REENTER_ROUND()				make the round of the enclosing CC_ROUND current again (after a recursive call)
+ *	CC_ROUND_EDGES(edges)			set the alive edges of the current round when they are known after CC_ROUND
+ *	CC_PHASE(PHASE)					time the rest of the enclosing scope as PHASE of the current round
+ *	CC_PHASE_START(PHASE)			time PHASE until CC_PHASE_STOP(PHASE) or the end of the scope (once per scope)
+ *	CC_PHASE_BYTES(PHASE, bytes)	bytes moved (sent, received or produced) by PHASE in the current round
+ *	CC_SWEEPS(count)				pointer jumping sweeps of the current round
+ *	CC_THREAD_SPAN(PHASE)			inside a parallel region: trace the rest of the enclosing scope on the track of the thread
+ *
+ * Only the thread that calls the engine records the rounds, and one engine runs at a time in a process.
+ * When the Tracer is enabled the phases and the thread spans are also kept as a timeline (Chrome trace events),
+ * when the PerfCounters are enabled every phase also counts the hardware events of all the threads of the process.
+ * Every phase also records the allocations of the MemoryTracker and samples the resident memory when it ends.
+ */
+namespace cc
+{
+
+enum class Phase : int
+{
+	SCATTER,
+	HOOK,
+	REDUCE,
+	FIND_ROOTS,
+	BCAST,
+	COMPUTE_NEXT_EDGES,
+	GATHER,
+	SAMPLE,
+	CONTRACT,
+	APPLY
+};
+
+const int PHASE_COUNT = 10;
+
+inline const char* phase_name(int phase)
+{
+	static const char* names[PHASE_COUNT] = {"scatter", "hook", "reduce", "find_roots", "bcast", "compute_next_edges", "gather", "sample", "contract", "apply"};
+	return names[phase];
+}
+
+struct PhaseStats
+{
+	double time = 0;		// Seconds
+	uint64_t bytes = 0;
+	uint64_t calls = 0;
+	double counters[COUNTER_COUNT] = {};	// Hardware events of the threads of the process, see PerfCounters
+	uint64_t allocations = 0;			// Operator new calls, see MemoryTracker
+	uint64_t allocated = 0;				// Bytes of these calls
+	uint64_t heap_peak = 0;				// Highest bytes in use on the heap of the process during the phase
+	uint64_t resident = 0;				// Highest resident memory of the process at the end of the phase
+};
+
+struct RoundStats
+{
+	uint64_t edges = 0;
+	uint64_t vertices = 0;
+	uint64_t sweeps = 0;
+	PhaseStats phases[PHASE_COUNT];
+};
+
+// Values of a round packed for the reductions between the processes: edges, vertices, sweeps,
+// then time, bytes, calls, the counters, allocations, allocated, heap_peak and resident of every phase
+const int MEMORY_VALUES = 3 + COUNTER_COUNT;
+const int PHASE_VALUES = MEMORY_VALUES + 4;
+const int ROUND_VALUES = 3 + PHASE_VALUES * PHASE_COUNT;
+
+// Record of the rounds of the last engine run by the process
+class Instrumentation
+{
+public:
+	string engine_;
+	vector<RoundStats> rounds_;
+	size_t current_ = 0;		// Round of the phases
+
+	static Instrumentation& instance()
+	{
+		static Instrumentation instrumentation;
+		return instrumentation;
+	}
+
+	void reset(const string& engine)
+	{
+		engine_ = engine;
+		rounds_.clear();
+		current_ = 0;
+	}
+
+	size_t beginRound(uint64_t edges, uint64_t vertices)
+	{
+		rounds_.emplace_back();
+		rounds_.back().edges = edges;
+		rounds_.back().vertices = vertices;
+		current_ = rounds_.size() - 1;
+		return current_;
+	}
+
+	// Phases recorded before the first round open it
+	RoundStats& current()
+	{
+		if (rounds_.empty())
+			beginRound(0, 0);
+		return rounds_[current_];
+	}
+
+	// One call of the phase, measured by a PhaseTimer
+	void addPhase(Phase phase, const PhaseStats& call)
+	{
+		PhaseStats& stats = current().phases[(int)phase];
+		stats.time += call.time;
+		stats.calls++;
+		for (int c = 0; c < COUNTER_COUNT; c++)
+			stats.counters[c] += call.counters[c];
+		stats.allocations += call.allocations;
+		stats.allocated += call.allocated;
+		stats.heap_peak = std::max(stats.heap_peak, call.heap_peak);
+		stats.resident = std::max(stats.resident, call.resident);
+	}
+
+	void addBytes(Phase phase, uint64_t bytes) { current().phases[(int)phase].bytes += bytes; }
+	void addSweeps(uint64_t sweeps) { current().sweeps += sweeps; }
+
+	// round_count values per round, the missing rounds are zeros
+	vector<double> pack(size_t round_count) const
+	{
+		vector<double> values(round_count * ROUND_VALUES, 0);
+		for (size_t r = 0; r < rounds_.size() && r < round_count; r++)
+		{
+			double* round = &values[r * ROUND_VALUES];
+			round[0] = rounds_[r].edges;
+			round[1] = rounds_[r].vertices;
+			round[2] = rounds_[r].sweeps;
+			for (int p = 0; p < PHASE_COUNT; p++)
+			{
+				double* phase = round + 3 + PHASE_VALUES * p;
+				phase[0] = rounds_[r].phases[p].time;
+				phase[1] = rounds_[r].phases[p].bytes;
+				phase[2] = rounds_[r].phases[p].calls;
+				for (int c = 0; c < COUNTER_COUNT; c++)
+					phase[3 + c] = rounds_[r].phases[p].counters[c];
+				phase[MEMORY_VALUES] = rounds_[r].phases[p].allocations;
+				phase[MEMORY_VALUES + 1] = rounds_[r].phases[p].allocated;
+				phase[MEMORY_VALUES + 2] = rounds_[r].phases[p].heap_peak;
+				phase[MEMORY_VALUES + 3] = rounds_[r].phases[p].resident;
+			}
+		}
+		return values;
+	}
+
+	/**
+	 * JSON report of the rounds, from the values packed by every process
+	 * @param max the maximum over the processes of every packed value
+	 * @param sum the sum over the processes of every packed value
+	 * @param processes the number of processes (1: max and sum are the values of this process)
+	 */
+	void writeJson(ostream& out, const vector<double>& max, const vector<double>& sum, int processes) const
+	{
+		size_t round_count = max.size() / ROUND_VALUES;
+		vector<double> total_max(PHASE_VALUES * PHASE_COUNT, 0), total_sum(PHASE_VALUES * PHASE_COUNT, 0);
+
+		out.precision(9);
+		out << "{\n  \"engine\": \"" << engine_ << "\",\n  \"processes\": " << processes << ",\n  \"counters\": {";
+		// The hardware counters that were measured, and why the others were not
+		const PerfCounters& counters = PerfCounters::instance();
+		for (int c = 0; c < COUNTER_COUNT; c++)
+			out << (c > 0 ? ", " : "") << "\"" << counter_name(c) << "\": \"" << (counters.available(c) ? "available" : counters.reason(c).empty() ? "disabled" : counters.reason(c)) << "\"";
+		out << "},\n  \"allocation_tracking\": " << (MemoryTracker::instance().hooked_ ? "true" : "false") << ",\n  \"rounds\": [\n";
+		for (size_t r = 0; r < round_count; r++)
+		{
+			const double* round_max = &max[r * ROUND_VALUES];
+			const double* round_sum = &sum[r * ROUND_VALUES];
+			// Peaks of the round: the highest of its phases, on the process where it is the highest
+			double heap_peak = 0, resident = 0;
+			for (int p = 0; p < PHASE_COUNT; p++)
+			{
+				heap_peak = std::max(heap_peak, round_max[3 + PHASE_VALUES * p + MEMORY_VALUES + 2]);
+				resident = std::max(resident, round_max[3 + PHASE_VALUES * p + MEMORY_VALUES + 3]);
+			}
+			out << "    {\"round\": " << r + 1 << ", \"edges\": " << (uint64_t)round_max[0] << ", \"vertices\": " << (uint64_t)round_max[1]
+				<< ", \"sweeps\": " << (uint64_t)round_max[2] << ", \"heap_peak_max\": " << (uint64_t)heap_peak
+				<< ", \"resident_max\": " << (uint64_t)resident << ", \"phases\": {";
+			writePhases(out, round_max + 3, round_sum + 3, processes);
+			out << "}}" << (r + 1 < round_count ? ",\n" : "\n");
+
+			for (int i = 0; i < PHASE_VALUES * PHASE_COUNT; i++)
+			{
+				// The peaks are not summed over the rounds
+				bool peak = i % PHASE_VALUES >= MEMORY_VALUES + 2;
+				total_max[i] = peak ? std::max(total_max[i], round_max[3 + i]) : total_max[i] + round_max[3 + i];
+				total_sum[i] = peak ? std::max(total_sum[i], round_sum[3 + i]) : total_sum[i] + round_sum[3 + i];
+			}
+		}
+		// Totals: the max over the processes of every round, summed (the critical path when the rounds are synchronized)
+		out << "  ],\n  \"totals\": {";
+		writePhases(out, total_max.data(), total_sum.data(), processes);
+		out << "}\n}\n";
+	}
+
+	// Report of this process alone
+	void writeJson(ostream& out) const
+	{
+		vector<double> values = pack(rounds_.size());
+		writeJson(out, values, values, 1);
+	}
+
+private:
+	// The phases that ran: max and average over the processes, imbalance = max / average; the counters and the allocations
+	// are summed over the processes, the peaks of memory are the highest of a process
+	static void writePhases(ostream& out, const double* max, const double* sum, int processes)
+	{
+		bool first = true;
+		for (int p = 0; p < PHASE_COUNT; p++)
+		{
+			const double* phase_max = max + PHASE_VALUES * p;
+			const double* phase_sum = sum + PHASE_VALUES * p;
+			if (phase_max[2] == 0)
+				continue;
+
+			double time_avg = phase_sum[0] / processes;
+			out << (first ? "" : ", ") << "\"" << phase_name(p) << "\": {\"time_max\": " << phase_max[0] << ", \"time_avg\": " << time_avg
+				<< ", \"imbalance\": " << (time_avg > 0 ? phase_max[0] / time_avg : 1) << ", \"bytes_max\": " << (uint64_t)phase_max[1]
+				<< ", \"bytes_total\": " << (uint64_t)phase_sum[1] << ", \"calls\": " << (uint64_t)phase_max[2];
+			for (int c = 0; c < COUNTER_COUNT; c++)
+				if (PerfCounters::instance().available(c))
+					out << ", \"" << counter_name(c) << "\": " << (uint64_t)phase_sum[3 + c];
+			if (MemoryTracker::instance().hooked_)
+				out << ", \"allocations\": " << (uint64_t)phase_sum[MEMORY_VALUES] << ", \"allocated_bytes\": " << (uint64_t)phase_sum[MEMORY_VALUES + 1]
+					<< ", \"heap_peak_max\": " << (uint64_t)phase_max[MEMORY_VALUES + 2];
+			out << ", \"resident_max\": " << (uint64_t)phase_max[MEMORY_VALUES + 3] << "}";
+			first = false;
+		}
+	}
+};
+
+struct TraceEvent
+{
+	double start;		// Seconds since the epoch of the tracer
+	double end;
+	int16_t phase;
+	bool thread_span;	// Work of one thread in a parallel region, otherwise a phase of the engine
+};
+
+/**
+ * Timeline of the phases for chrome://tracing and Perfetto: one process per MPI rank, one track per OpenMP thread.
+ * Every thread appends to its own preallocated buffer: recording is two clock reads and a store, without locks
+ * and without allocations. The events that do not fit are dropped and counted
+ */
+class Tracer
+{
+	// Padded so that the sizes of the buffers of different threads are not on the same cache line
+	struct ThreadBuffer
+	{
+		vector<TraceEvent> events;
+		char padding[64];
+	};
+
+	bool enabled_ = false;
+	double epoch_ = 0;
+	size_t capacity_ = 0;
+	vector<ThreadBuffer> buffers_;
+	atomic<uint64_t> dropped_{0};
+
+public:
+	static Tracer& instance()
+	{
+		static Tracer tracer;
+		return tracer;
+	}
+
+	bool enabled() const { return enabled_; }
+	uint64_t dropped() const { return dropped_; }
+
+	/**
+	 * Start tracing: the buffers of the threads of the next parallel regions are allocated here
+	 * @param capacity events per thread
+	 */
+	void enable(size_t capacity = 1 << 16)
+	{
+		capacity_ = capacity;
+		buffers_.assign(omp_get_max_threads(), ThreadBuffer());
+		for (ThreadBuffer& buffer : buffers_)
+			buffer.events.reserve(capacity_);
+		dropped_ = 0;
+		epoch_ = omp_get_wtime();
+		enabled_ = true;
+	}
+
+	void disable() { enabled_ = false; }
+
+	// Called by the thread that ran the span
+	void record(int phase, bool thread_span, double start, double end)
+	{
+		size_t thread = omp_get_thread_num();
+		if (thread >= buffers_.size() || buffers_[thread].events.size() == capacity_)
+		{
+			dropped_++;
+			return;
+		}
+		buffers_[thread].events.push_back(TraceEvent{start - epoch_, end - epoch_, (int16_t)phase, thread_span});
+	}
+
+	/**
+	 * Append the events of this process to out, comma separated, as trace events of the process pid (the MPI rank).
+	 * The names of the process and of the tracks come first
+	 */
+	void appendEvents(string& out, int pid) const
+	{
+		char event[256];
+		snprintf(event, sizeof(event), "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"rank %d\"}}", pid, pid);
+		out += out.empty() ? "" : ",\n";
+		out += event;
+		for (size_t thread = 0; thread < buffers_.size(); thread++)
+		{
+			if (buffers_[thread].events.empty())
+				continue;
+			snprintf(event, sizeof(event), ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%zu,\"args\":{\"name\":\"thread %zu\"}}", pid, thread, thread);
+			out += event;
+			for (const TraceEvent& e : buffers_[thread].events)
+			{
+				// Microseconds
+				snprintf(event, sizeof(event), ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%zu}",
+					phase_name(e.phase), e.thread_span ? "thread" : "phase", e.start * 1e6, (e.end - e.start) * 1e6, pid, thread);
+				out += event;
+			}
+		}
+	}
+
+	// Trace of this process alone
+	void writeJson(ostream& out) const
+	{
+		string events;
+		appendEvents(events, 0);
+		out << "{\"traceEvents\":[\n" << events << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	}
+};
+
+// Traces its scope on the track of the calling thread, inside a parallel region
+class ThreadSpan
+{
+	int phase_;
+	double start_;
+
+public:
+	explicit ThreadSpan(Phase phase) : phase_((int)phase), start_(Tracer::instance().enabled() ? omp_get_wtime() : 0) {}
+
+	~ThreadSpan()
+	{
+		Tracer& tracer = Tracer::instance();
+		if (tracer.enabled())
+			tracer.record(phase_, true, start_, omp_get_wtime());
+	}
+};
+
+// Times its scope, or until stop, as a phase of the current round (traced and counted when the Tracer and the PerfCounters are enabled)
+class PhaseTimer
+{
+	Phase phase_;
+	double start_;
+	double counters_[COUNTER_COUNT];
+	uint64_t allocations_, allocated_;
+	uint64_t outer_peak_;		// Peak of the enclosing phase, if any
+	bool stopped_ = false;
+
+public:
+	explicit PhaseTimer(Phase phase) : phase_(phase)
+	{
+		MemoryTracker& tracker = MemoryTracker::instance();
+		allocations_ = tracker.allocations_;
+		allocated_ = tracker.allocated_;
+		outer_peak_ = tracker.resetPeak();
+		PerfCounters::instance().read(counters_);
+		start_ = omp_get_wtime();
+	}
+
+	~PhaseTimer() { stop(); }
+
+	void stop()
+	{
+		if (stopped_)
+			return;
+		double end = omp_get_wtime();
+		PhaseStats call;
+		call.time = end - start_;
+		const PerfCounters& perf_counters = PerfCounters::instance();
+		if (perf_counters.enabled())
+		{
+			perf_counters.read(call.counters);
+			for (int c = 0; c < COUNTER_COUNT; c++)
+				call.counters[c] -= counters_[c];
+		}
+		MemoryTracker& tracker = MemoryTracker::instance();
+		call.allocations = tracker.allocations_ - allocations_;
+		call.allocated = tracker.allocated_ - allocated_;
+		call.heap_peak = tracker.endPeak(outer_peak_);
+		call.resident = resident_bytes();
+		Instrumentation::instance().addPhase(phase_, call);
+		Tracer& tracer = Tracer::instance();
+		if (tracer.enabled())
+			tracer.record((int)phase_, false, start_, end);
+		stopped_ = true;
+	}
+};
+
+// Number of roots (labels[v] == v): the vertices still alive in the hooking engines
+inline uint64_t count_roots(const uint32_t* labels, uint32_t vertex_count)
+{
+	uint64_t roots = 0;
+	#pragma omp parallel for reduction(+:roots)
+	for (uint32_t i = 0; i < vertex_count; i++)
+		roots += labels[i] == i;
+	return roots;
+}
+
+} // namespace cc
+
+#ifdef CC_INSTRUMENT
+#define CC_CONCAT_(a, b) a##b
+#define CC_CONCAT(a, b) CC_CONCAT_(a, b)
+#define CC_ROUND(edges, vertices) const size_t cc_round_ __attribute__((unused)) = cc::Instrumentation::instance().beginRound(edges, vertices)
+#define CC_REENTER_ROUND() cc::Instrumentation::instance().current_ = cc_round_
+#define CC_ROUND_EDGES(edge_count) cc::Instrumentation::instance().current().edges = (edge_count)
+#define CC_PHASE(phase) cc::PhaseTimer CC_CONCAT(cc_phase_, __LINE__)(cc::Phase::phase)
+#define CC_PHASE_START(phase) cc::PhaseTimer cc_phase_##phase(cc::Phase::phase)
+#define CC_PHASE_STOP(phase) cc_phase_##phase.stop()
+#define CC_PHASE_BYTES(phase, bytes) cc::Instrumentation::instance().addBytes(cc::Phase::phase, bytes)
+#define CC_SWEEPS(count) cc::Instrumentation::instance().addSweeps(count)
+#define CC_THREAD_SPAN(phase) cc::ThreadSpan CC_CONCAT(cc_span_, __LINE__)(cc::Phase::phase)
+#else
+#define CC_ROUND(edges, vertices)
+#define CC_REENTER_ROUND()
+#define CC_ROUND_EDGES(edge_count)
+#define CC_PHASE(phase)
+#define CC_PHASE_START(phase)
+#define CC_PHASE_STOP(phase)
+#define CC_PHASE_BYTES(phase, bytes)
+#define CC_SWEEPS(count)
+#define CC_THREAD_SPAN(phase)
+#endif
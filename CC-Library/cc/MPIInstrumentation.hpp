@@ -0,0 +1,75 @@
+#pragma once
+
+#include <mpi.h>
+//Standard libraries
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdint>
+//Custom libraries
+#include "Instrumentation.hpp"
+
+using namespace std;
+
+namespace cc
+{
+
+/**
+ * JSON report of the rounds of all the processes: max, average and imbalance of every phase. Collective call:
+ * the processes may have recorded different numbers of rounds, the missing ones count as zeros
+ * @param out written on the root only
+ */
+inline void write_instrumentation_report(ostream& out, MPI_Comm communicator)
+{
+	int rank, processes;
+	MPI_Comm_rank(communicator, &rank);
+	MPI_Comm_size(communicator, &processes);
+
+	const Instrumentation& instrumentation = Instrumentation::instance();
+	unsigned long long local_rounds = instrumentation.rounds_.size(), round_count = 0;
+	MPI_Allreduce(&local_rounds, &round_count, 1, MPI_UNSIGNED_LONG_LONG, MPI_MAX, communicator);
+
+	vector<double> values = instrumentation.pack(round_count);
+	vector<double> max(values.size()), sum(values.size());
+	MPI_Reduce(values.data(), max.data(), values.size(), MPI_DOUBLE, MPI_MAX, 0, communicator);
+	MPI_Reduce(values.data(), sum.data(), values.size(), MPI_DOUBLE, MPI_SUM, 0, communicator);
+
+	if (rank == 0)
+		instrumentation.writeJson(out, max, sum, processes);
+}
+
+/**
+ * Trace of all the processes in one file, every rank is a process of the timeline. Collective call: the events
+ * are serialized by every process and gathered on the root. The clocks of the processes are aligned by the barrier
+ * that precedes Tracer::enable
+ * @param out written on the root only
+ */
+inline void write_trace(ostream& out, MPI_Comm communicator)
+{
+	int rank, processes;
+	MPI_Comm_rank(communicator, &rank);
+	MPI_Comm_size(communicator, &processes);
+
+	string events;
+	Tracer::instance().appendEvents(events, rank);
+	int size = events.size();
+	vector<int> sizes(processes), displacements(processes, 0);
+	MPI_Gather(&size, 1, MPI_INT, sizes.data(), 1, MPI_INT, 0, communicator);
+
+	string all_events;
+	if (rank == 0)
+	{
+		// The events of every process are followed by a separator
+		for (int p = 1; p < processes; p++)
+			displacements[p] = displacements[p - 1] + sizes[p - 1] + 2;
+		all_events.assign(displacements[processes - 1] + sizes[processes - 1], ',');
+		for (int p = 0; p + 1 < processes; p++)
+			all_events[displacements[p] + sizes[p] + 1] = '\n';
+	}
+	MPI_Gatherv(&events[0], size, MPI_CHAR, &all_events[0], sizes.data(), displacements.data(), MPI_CHAR, 0, communicator);
+
+	if (rank == 0)
+		out << "{\"traceEvents\":[\n" << all_events << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+} // namespace cc
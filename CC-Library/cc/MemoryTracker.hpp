@@ -0,0 +1,169 @@
+#pragma once
+
+//Standard libraries
+#include <atomic>
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+/*
+ * Heap accounting of the process: every operator new and delete of the program updates the bytes in use,
+ * the peak and the allocations. The translation unit of main defines CC_ALLOCATION_HOOKS before including this
+ * header to replace the global operators (once per program). Without the hooks the counts stay at zero and
+ * only the resident memory is sampled. The allocations of the C libraries (malloc in MPI) are not counted,
+ * they appear in the resident memory.
+ */
+namespace cc
+{
+
+class MemoryTracker
+{
+public:
+	atomic<bool> hooked_{false};		// The operators of this header are linked in
+	atomic<uint64_t> in_use_{0};		// Bytes
+	atomic<uint64_t> peak_{0};			// Highest in_use_ since the last resetPeak
+	atomic<uint64_t> allocations_{0};
+	atomic<uint64_t> allocated_{0};		// Bytes, freed or not
+
+	static MemoryTracker& instance()
+	{
+		static MemoryTracker tracker;
+		return tracker;
+	}
+
+	void allocated(size_t bytes)
+	{
+		uint64_t in_use = in_use_.fetch_add(bytes, memory_order_relaxed) + bytes;
+		allocations_.fetch_add(1, memory_order_relaxed);
+		allocated_.fetch_add(bytes, memory_order_relaxed);
+		uint64_t peak = peak_.load(memory_order_relaxed);
+		while (in_use > peak && !peak_.compare_exchange_weak(peak, in_use, memory_order_relaxed))
+			;
+	}
+
+	void freed(size_t bytes) { in_use_.fetch_sub(bytes, memory_order_relaxed); }
+
+	/**
+	 * Start a new window of the peak at the current use
+	 * @return the peak of the previous window, to restore with endPeak when the windows are nested
+	 */
+	uint64_t resetPeak()
+	{
+		uint64_t peak = peak_.load();
+		peak_ = in_use_.load();
+		return peak;
+	}
+
+	// Peak of the window, merged back into the window that was open before it
+	uint64_t endPeak(uint64_t outer_peak)
+	{
+		uint64_t peak = peak_.load();
+		if (outer_peak > peak)
+			peak_ = outer_peak;
+		return peak;
+	}
+};
+
+// Resident memory of the process in bytes, from /proc/self/statm (0 if not available)
+inline uint64_t resident_bytes()
+{
+	#ifdef __linux__
+	FILE* statm = fopen("/proc/self/statm", "r");
+	if (statm == nullptr)
+		return 0;
+	unsigned long long size = 0, resident = 0;
+	int read = fscanf(statm, "%llu %llu", &size, &resident);
+	fclose(statm);
+	return read == 2 ? resident * sysconf(_SC_PAGESIZE) : 0;
+	#else
+	return 0;
+	#endif
+}
+
+// Size of the block, in front of it: keeps the alignment of malloc
+const size_t ALLOCATION_HEADER = 16;
+
+// Not inlined in the callers of new and delete, where the compiler would see free on a pointer returned by new
+__attribute__((noinline)) inline void* tracked_allocate(size_t bytes)
+{
+	char* block = (char*)malloc(bytes + ALLOCATION_HEADER);
+	if (block == nullptr)
+		return nullptr;
+	*(size_t*)block = bytes;
+	MemoryTracker& tracker = MemoryTracker::instance();
+	tracker.hooked_.store(true, memory_order_relaxed);
+	tracker.allocated(bytes);
+	return block + ALLOCATION_HEADER;
+}
+
+__attribute__((noinline)) inline void tracked_free(void* pointer)
+{
+	if (pointer == nullptr)
+		return;
+	char* block = (char*)pointer - ALLOCATION_HEADER;
+	MemoryTracker::instance().freed(*(size_t*)block);
+	free(block);
+}
+
+} // namespace cc
+
+#ifdef CC_ALLOCATION_HOOKS
+void* operator new(size_t bytes)
+{
+	void* pointer = cc::tracked_allocate(bytes);
+	if (pointer == nullptr)
+		throw bad_alloc();
+	return pointer;
+}
+
+void* operator new[](size_t bytes)
+{
+	return operator new(bytes);
+}
+
+void* operator new(size_t bytes, const nothrow_t&) noexcept
+{
+	return cc::tracked_allocate(bytes);
+}
+
+void* operator new[](size_t bytes, const nothrow_t&) noexcept
+{
+	return cc::tracked_allocate(bytes);
+}
+
+void operator delete(void* pointer) noexcept
+{
+	cc::tracked_free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	cc::tracked_free(pointer);
+}
+
+void operator delete(void* pointer, const nothrow_t&) noexcept
+{
+	cc::tracked_free(pointer);
+}
+
+void operator delete[](void* pointer, const nothrow_t&) noexcept
+{
+	cc::tracked_free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	cc::tracked_free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	cc::tracked_free(pointer);
+}
+#endif
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <mpi.h>
+//Standard libraries
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// Array of uint32_t shared by all the processes running on the same node (MPI-3 shared memory window).
+// Only one copy of the array lives on every node: the processes of the node read and write it directly,
+// while the exchanges between the nodes are done by one leader process per node.
+class NodeSharedArray
+{
+private:
+	MPI_Comm node_comm_;		// Processes on the same node
+	MPI_Comm leader_comm_;		// One process per node (MPI_COMM_NULL for the processes that are not leaders)
+	MPI_Win window_;			// Shared memory window
+	int32_t node_rank_, node_size_;
+	uint32_t size_;
+	uint32_t* data_;
+	bool allocated_;
+
+public:
+	NodeSharedArray(MPI_Comm communicator, uint32_t size) : size_(size), data_(nullptr), allocated_(true)
+	{
+		int32_t rank;
+		MPI_Comm_rank(communicator, &rank);
+
+		// Group the processes that can share memory. The key keeps the original order, so rank 0 is always a leader
+		MPI_Comm_split_type(communicator, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node_comm_);
+		MPI_Comm_rank(node_comm_, &node_rank_);
+		MPI_Comm_size(node_comm_, &node_size_);
+
+		// The first process of every node is the leader of the node
+		MPI_Comm_split(communicator, leader() ? 0 : MPI_UNDEFINED, rank, &leader_comm_);
+
+		// Only the leader allocates the memory, the other processes get a pointer to the leader segment
+		MPI_Aint local_size = leader() ? (MPI_Aint)size_ * sizeof(uint32_t) : 0;
+		MPI_Win_allocate_shared(local_size, sizeof(uint32_t), MPI_INFO_NULL, node_comm_, &data_, &window_);
+		if (!leader())
+		{
+			MPI_Aint segment_size;
+			int displacement_unit;
+			MPI_Win_shared_query(window_, 0, &segment_size, &displacement_unit, &data_);
+		}
+
+		// Passive target epoch for the whole life of the window: the processes synchronize with MPI_Win_sync and barriers
+		MPI_Win_lock_all(MPI_MODE_NOCHECK, window_);
+	}
+
+	NodeSharedArray(const NodeSharedArray &that) = delete;
+
+	// The window must be released before MPI_Finalize
+	~NodeSharedArray() { release(); }
+
+	void release()
+	{
+		if (!allocated_)
+			return;
+
+		MPI_Win_unlock_all(window_);
+		MPI_Win_free(&window_);
+		if (leader_comm_ != MPI_COMM_NULL)
+			MPI_Comm_free(&leader_comm_);
+		MPI_Comm_free(&node_comm_);
+		allocated_ = false;
+	}
+
+	uint32_t* data() { return data_; }
+	uint32_t size() const { return size_; }
+	bool leader() const { return node_rank_ == 0; }
+	int32_t nodeSize() const { return node_size_; }
+
+	// Make the writes of every process of the node visible to the others
+	void synchronize()
+	{
+		MPI_Win_sync(window_);
+		MPI_Barrier(node_comm_);
+		MPI_Win_sync(window_);
+	}
+
+	// Broadcast the first count elements of the array of rank 0 to every node
+	void broadcast(uint32_t count)
+	{
+		// No process of the node must be still reading the old values
+		synchronize();
+		if (leader())
+			MPI_Bcast(data_, count, MPI_UINT32_T, 0, leader_comm_);
+		synchronize();
+	}
+
+	// Reduce with MPI_MAX the first count elements of the arrays of every node into the array of rank 0
+	void reduceMax(uint32_t count)
+	{
+		// Every process of the node must have finished writing
+		synchronize();
+		if (leader())
+		{
+			int32_t leader_rank;
+			MPI_Comm_rank(leader_comm_, &leader_rank);
+			if (leader_rank == 0)
+				MPI_Reduce(MPI_IN_PLACE, data_, count, MPI_UINT32_T, MPI_MAX, 0, leader_comm_);
+			else
+				MPI_Reduce(data_, nullptr, count, MPI_UINT32_T, MPI_MAX, 0, leader_comm_);
+		}
+	}
+
+	// Atomic max, safe with the other processes of the node writing the same element
+	static inline void atomicMax(uint32_t* address, uint32_t value)
+	{
+		uint32_t current = __atomic_load_n(address, __ATOMIC_RELAXED);
+		while (current < value && !__atomic_compare_exchange_n(address, &current, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			;
+	}
+};
@@ -0,0 +1,451 @@
+#pragma once
+
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cassert>
+#include <random>
+#include <algorithm>
+//Custom libraries
+#include "Edge.hpp"
+#include "EdgeSpan.hpp"
+#include "Instrumentation.hpp"
+
+using namespace std;
+
+// Kernels and recursions of the deterministic and the randomized OpenMP connected components (CSE613)
+namespace cc
+{
+
+// Random number generator of the randomized version
+// Note: omp threadprivate does not work with mt19937, for some unknown reason
+// Note2: rand_r is not an option. It is thread safe and works with omp threadprivate, but is not a good random number generator 
+// and give ciclic results that break the algorithm
+// Note3: I'm using a thread_local variable: the behavior is the same as threadprivate, but it is a C++11 feature. 
+// However, the behavior with openmp is not defined, and it is compiler dependent. With GCC it works as expected.
+// Note4: The merseene twister is a very good random number generator, but it is heavy and slow.
+// Maybe we should use a faster random number generator, like xorshift
+// The generator lives in a function so that the header can be included by several translation units
+inline mt19937& random_generator()
+{
+	static thread_local mt19937 generator;
+	return generator;
+}
+
+// Print the number of edges of every iteration and the iterations without progress (on by default, per calling thread)
+inline bool& verbose_iterations()
+{
+	static thread_local bool verbose = true;
+	return verbose;
+}
+
+// Resize a buffer without keeping its content: it is only reallocated when its capacity is too small
+template <typename T>
+inline T* reuse(vector<T>& buffer, size_t size)
+{
+	if (buffer.capacity() < size)
+		vector<T>().swap(buffer);
+	buffer.resize(size);
+	return buffer.data();
+}
+
+// Buffers of the rounds of the engines. cc::Context keeps them between the calls, so labelling a graph
+// again allocates nothing; the legacy drivers use a local set for each call
+struct RoundBuffers
+{
+	// Ranks of the union-find of the serial engine
+	vector<unsigned> ranks;
+	vector<uint32_t> edges_mark, prefix_sum;
+	// Not vector<bool>: the threads write neighbouring elements
+	vector<uint8_t> coin_toss;
+	// Edges of every round. The deterministic engine alternates between the first two, the randomized one keeps
+	// every round for map_results_back. Growing the outer vector moves the inner ones: their data does not move
+	vector<vector<Edge>> next_edges;
+
+	vector<Edge>& round_edges(size_t round)
+	{
+		if (next_edges.size() <= round)
+			next_edges.resize(round + 1);
+		return next_edges[round];
+	}
+};
+
+// Used in both randomized_cc.cpp and deterministic_cc.cpp
+// @param [out] nextEdges the edges between different groups, relabelled: a buffer of buffers.next_edges
+inline void find_rank_and_remove_edges(uint32_t nNodes, EdgeSpan edges, const uint32_t* labels, RoundBuffers& buffers, vector<Edge>& nextEdges)
+{
+	uint32_t* edges_mark = reuse(buffers.edges_mark, edges.size());
+	uint32_t* prefix_sum = reuse(buffers.prefix_sum, edges.size());
+	// Temporary variable for the prefix sum
+	uint32_t prefix_sum_temp = 0;
+
+	#pragma omp parallel shared(nNodes, edges, labels, edges_mark, prefix_sum, nextEdges) 
+	{
+		// Prepare to remove edges inside the same group
+		// The barrier is explicit so that the span of the thread ends when its work does
+		{
+			CC_THREAD_SPAN(COMPUTE_NEXT_EDGES);
+			#pragma omp for nowait
+			for(uint32_t i = 0; i < edges.size(); i++)
+			{
+				uint32_t from = edges[i].from;
+				uint32_t to = edges[i].to;
+
+				// If the nodes are in different groups, mark the edge (the buffer is not cleared between the rounds)
+				//Not a race condition because each thread writes to a different index
+				edges_mark[i] = labels[from] != labels[to];
+			}
+		}
+		#pragma omp barrier
+
+		// if __GNUC__ >= 10, use the new omp scan directive
+		// Otherwise, use the old way to do a prefix sum
+		#if __GNUC__ >= 10
+		// Prefix sum with parallel for
+		#pragma omp for reduction(inscan, + : prefix_sum_temp)
+        for (uint32_t i = 0; i < edges.size(); i++) {
+            
+            prefix_sum_temp += edges_mark[i]; 
+            #pragma omp scan inclusive(prefix_sum_temp)
+            prefix_sum[i] = prefix_sum_temp;
+        }
+		#else
+		// Prefix sum sequential
+		#pragma omp single
+		{
+			// Prefix sum
+			prefix_sum[0] = edges_mark[0];
+			for(uint32_t i = 1; i < edges.size(); i++)
+			{
+				prefix_sum[i] = edges_mark[i] + prefix_sum[i - 1];
+			}
+		}
+		#endif
+
+		// Size the nextEdges vector, allocated only if the previous calls did not need as many edges
+		#pragma omp single
+		reuse(nextEdges, prefix_sum[edges.size() - 1]);
+		
+		// Copy only edges that are between different groups (the end of the parallel region is the barrier)
+		CC_THREAD_SPAN(COMPUTE_NEXT_EDGES);
+		#pragma omp for nowait
+		for(uint32_t i = 0; i < edges.size(); i++)
+		{
+			uint32_t from = edges[i].from;
+			uint32_t to = edges[i].to;
+
+			// If the nodes are in different groups, add the edge to the nextEdges vector
+			if(labels[from] != labels[to])
+				//Not a race condition because:
+				// if the condition is true, edges_mark[i] will be 1, so prefix_sum[i] will be different from prefix_sum[i-1]
+				// Insert the edge in the correct position
+				nextEdges[prefix_sum[i] - 1] = (labels[from] < labels[to] ? Edge{labels[from], labels[to]} : Edge{labels[to], labels[from]});			
+		}
+	}
+}
+
+// Used in randomized_cc.cpp
+inline void map_results_back(uint32_t nNodes, EdgeSpan edges, const uint32_t* labels, uint32_t* map)
+{
+	#pragma omp parallel shared(edges, labels, map)
+	{
+		CC_THREAD_SPAN(APPLY);
+		#pragma omp for nowait
+		for(uint32_t i = 0; i < edges.size(); i++)
+		{
+			uint32_t from = edges[i].from;
+			uint32_t to = edges[i].to;
+
+			// The race condition is only in the labels that has been previously changed
+			// So, again, atomic writes is sufficient
+			
+			if(to == labels[from])
+			{
+				#pragma omp atomic write
+				map[from] = map[to];
+			}
+			else if(from == labels[to])
+			{
+				#pragma omp atomic write
+				map[to] = map[from];
+			}
+		}
+	}
+
+}
+
+// Used in deterministic_cc.cpp
+inline void find_roots(uint32_t nNodes, uint32_t* labels)
+{
+	// Let's break down the possibility of concurrency problems:
+	// 1. If a node is a root, it will basically not be changed
+	// 2. If a node is a leaf, it will be just written once and never read
+	// 3. If a node is in the middle of a chain, it will be read and written at least once -> problem
+
+	// I have done some tests with atomic read and atomic write, but it is slower 
+	// than just reading and writing without atomic operations and give the same results
+	// because the algorithm is sequantial consistent, so it is fine
+
+	bool found = true;
+
+	while(found)
+	{
+		found = false;
+		CC_SWEEPS(1);
+
+		#if false
+		#pragma omp parallel for shared(nNodes, labels) reduction(||:found)
+		for(uint32_t i = 0; i < nNodes; i++)
+		{
+			// I cannot safely read labels[labels[i]] because another thread can modify it
+			// With atomic read, I am sure that the value is "pulled" from the memory
+			uint32_t grandpa, new_gramdpa;
+			#pragma omp atomic read
+			grandpa = labels[labels[i]];
+			#pragma omp atomic read
+			new_gramdpa = labels[grandpa];
+			
+			// I cannot safely write labels[i] because another thread can read it 
+			// With atomic write, I am sure that the value is "pushed" to the memory
+			#pragma omp atomic write
+			labels[i] = grandpa;
+			// Maybe an flush is enough here instead of atomic write
+
+			if(grandpa != new_gramdpa)
+				found = true;
+		}
+		#else
+		#pragma omp parallel shared(nNodes, labels, found)
+		{
+			CC_THREAD_SPAN(FIND_ROOTS);
+			#pragma omp for nowait
+			for(uint32_t i = 0; i < nNodes; i++)
+			{
+				labels[i] = labels[labels[i]];
+
+				if(labels[i] != labels[labels[i]])
+					found = true;
+			}
+		}
+		#endif
+	}
+
+	return;
+}
+
+// Deterministic version: hook every edge, then pointer jumping. The labels of the nNodes vertices are computed in place
+inline uint32_t* par_deterministic_cc(uint32_t nNodes, EdgeSpan edges, uint32_t* labels, int* iteration, RoundBuffers& buffers, size_t round = 0) {
+
+	// Increment the iteration
+	(*iteration)++;
+
+	if(verbose_iterations())
+		cout << "Iteration " << *iteration << " Number of edges: " << edges.size() << endl;
+
+	// Base case
+	if(edges.size() == 0 || nNodes == 0) 
+		return labels;
+
+	CC_ROUND(edges.size(), count_roots(labels, nNodes));
+
+	{
+		CC_PHASE(HOOK);
+		#pragma omp parallel shared(nNodes, edges, labels)
+		{
+			CC_THREAD_SPAN(HOOK);
+			#pragma omp for nowait
+			for(uint32_t i = 0; i < edges.size(); i++)
+			{
+				// Always from the smaller to the bigger endpoint, so that the hooks cannot close a cycle: the edges
+				// of the caller do not need to be normalized, the next rounds are by find_rank_and_remove_edges
+				uint32_t from = min(edges[i].from, edges[i].to);
+				uint32_t to = max(edges[i].from, edges[i].to);
+
+				//if(labels[from] < to)
+				labels[from] = to;
+			}
+		}
+	}
+
+	// Find the roots for every node
+	{
+		CC_PHASE(FIND_ROOTS);
+		find_roots(nNodes, labels);
+	}
+
+	// Both buffers of the rounds take the edges of the call, more than any round: the rounds depend on the order
+	// of the concurrent hooks, but the next calls with as many edges do not allocate
+	if (round == 0)
+		for (size_t slot = 0; slot < 2; slot++)
+			if (buffers.round_edges(slot).capacity() < edges.size())
+			{
+				vector<Edge>().swap(buffers.round_edges(slot));
+				buffers.round_edges(slot).reserve(edges.size());
+			}
+
+	// Compute the new set of edges, in the buffer that the previous round does not read
+	vector<Edge>& nextEdges = buffers.round_edges(round % 2);
+	{
+		CC_PHASE(COMPUTE_NEXT_EDGES);
+		find_rank_and_remove_edges(nNodes, edges, labels, buffers, nextEdges);
+		CC_PHASE_BYTES(COMPUTE_NEXT_EDGES, nextEdges.size() * sizeof(Edge));
+	}
+
+	// Recursively call the function
+	return par_deterministic_cc(nNodes, nextEdges, labels, iteration, buffers, round + 1);
+}
+
+inline uint32_t* par_deterministic_cc(uint32_t nNodes, EdgeSpan edges, uint32_t* labels, int* iteration)
+{
+	RoundBuffers buffers;
+	return par_deterministic_cc(nNodes, edges, labels, iteration, buffers);
+}
+
+// Randomized version: hook a child to a parent chosen by a coin toss
+inline void coin_toss_and_child_hook(uint32_t nNodes, EdgeSpan edges, uint32_t* labels, RoundBuffers& buffers) 
+{
+	// Hook child to a parent based on the coin toss		
+	uint8_t* coin_toss = reuse(buffers.coin_toss, nNodes);
+
+	#pragma omp parallel shared(nNodes, edges, labels, coin_toss) 
+	{	
+		// Generate random coin tosses
+		mt19937& generator = random_generator();
+		{
+			CC_THREAD_SPAN(HOOK);
+			#pragma omp for nowait
+			for (uint32_t i = 0; i < nNodes; i++) {
+				// Not a race condition because each thread writes to a different index and has a different RNG
+				coin_toss[i] = generator() % 2; // Tail is True and Head is False
+			}
+		}
+		#pragma omp barrier
+
+		// Hook child to a parent based on the coin toss (the end of the parallel region is the barrier)
+		CC_THREAD_SPAN(HOOK);
+		#pragma omp for nowait
+		for(uint32_t i = 0; i < edges.size(); i++)
+		{
+			uint32_t from = edges[i].from;
+			uint32_t to = edges[i].to;
+
+			// Race condition ONLY labels that has coin_toss TRUE (labels that has coin_toss FALSE are read only)
+			// So atomic writes is sufficient 
+			if(coin_toss[from] && !coin_toss[to])
+			{
+				#pragma omp atomic write
+				labels[from] = labels[to];
+			}
+			else if(!coin_toss[from] && coin_toss[to])
+			{
+				#pragma omp atomic write
+				labels[to] = labels[from];
+			}
+		}
+	}
+
+	return;
+}
+
+inline uint32_t* par_randomized_cc(uint32_t nNodes, EdgeSpan edges, uint32_t* labels, int* iteration, RoundBuffers& buffers, size_t round = 0) 
+{
+	// Increment the iteration
+	(*iteration)++;
+
+	if(verbose_iterations())
+		cout << "Iteration " << *iteration << " Number of edges: " << edges.size() << endl;
+
+	// Base case
+	if(edges.size() == 0 || nNodes == 0) 
+		return labels;
+		
+	CC_ROUND(edges.size(), count_roots(labels, nNodes));
+
+	// Coin toss and child hook
+	{
+		CC_PHASE(HOOK);
+		coin_toss_and_child_hook(nNodes, edges, labels, buffers);
+	}
+
+	// Find the rank: the edges of this round stay in their buffer until map_results_back
+	vector<Edge>& nextEdges = buffers.round_edges(round);
+	{
+		CC_PHASE(COMPUTE_NEXT_EDGES);
+		find_rank_and_remove_edges(nNodes, edges, labels, buffers, nextEdges);
+		CC_PHASE_BYTES(COMPUTE_NEXT_EDGES, nextEdges.size() * sizeof(Edge));
+	}
+
+	if(nextEdges.size() == edges.size() && verbose_iterations())
+	{
+		//Print edges
+		cerr << "Error iteration " << *iteration << " (same edges as last iterarion): ";
+		for(uint32_t i = 0; i < edges.size(); i++)
+			cerr << "[" << edges[i].from << "," << edges[i].to << "] ";
+		cerr << endl;
+	}
+
+	// Recursively call the function (the deeper rounds can move nextEdges, the span keeps its data)
+	uint32_t* map = par_randomized_cc(nNodes, nextEdges, labels, iteration, buffers, round + 1);
+
+	//Map results back to the original graph
+	CC_REENTER_ROUND();
+	{
+		CC_PHASE(APPLY);
+		map_results_back(nNodes, edges, labels, map);
+	}
+
+	return map;
+}
+
+inline uint32_t* par_randomized_cc(uint32_t nNodes, EdgeSpan edges, uint32_t* labels, int* iteration)
+{
+	RoundBuffers buffers;
+	return par_randomized_cc(nNodes, edges, labels, iteration, buffers);
+}
+
+// A merseene twister is private to each thread and persistent across calls
+// Every thread will have a different seed
+inline void configure_RNG()
+{
+	// Prime numbers for the random number generator seed: usefull to have streems of random numbers that are not correlated
+	// A static array: configuring the generators allocates nothing
+	static const int prime_numbers[] = {3,5,7,11,13,17,19,23,29,31,37,41,43,47,53,59,61,67,71,73,79,83,89,97,101,103,107,109,113,127,131,137,139,149,151,157,163,167,173,179,181,191,193,197,199,211,223,227,229,233,239,241,251,257,263,269,271,277,281,283,293,307,311,313,317,331,337,347,349,353,359,367,373,379,383,389,397,401,409,419,421,431,433,439,443,449,457,461,463,467,479,487,491,499,503,509,521,523,541,547,557,563,569,571,577,587,593,599,601,607,613,617,619,631,641,643,647,653,659,661,673,677,683,691,701,709,719,727,733,739,743,751,757,761,769,773,787,797,809,811,821,823,827,829,839,853,857,859,863,877,881,883,887,907,911,919,929,937,941,947,953,967,971,977,983,991,997,1009,1013,1019,1021,1031,1033,1039,1049,1051,1061,1063,1069,1087,1091,1093,1097,1103,1109,1117,1123,1129,1151,1153,1163,1171,1181,1187,1193,1201,1213,1217,1223};
+
+    #pragma omp parallel
+    {
+		if((size_t)omp_get_thread_num() >= sizeof(prime_numbers) / sizeof(prime_numbers[0]))
+		{
+			cout << "Error: Not enough prime numbers for the random number generator" << endl;
+			exit(1);
+		}
+		// Seed the random number generator for each thread
+		random_generator() = mt19937(prime_numbers[omp_get_thread_num()]);
+    }
+
+	// To test the random number generator
+	#if false
+	vector<vector<uint32_t>> random_numbers(omp_get_max_threads());
+	#pragma omp parallel
+	{
+		// Generate random numbers
+		for (uint32_t i = 0; i < 10; i++) {
+			random_numbers[omp_get_thread_num()].push_back(random_generator()());
+		}
+	}
+	// Print the random numbers
+	for (uint32_t i = 0; i < random_numbers.size(); i++) {
+		cout << "Thread " << i << ": ";
+		for (uint32_t j = 0; j < random_numbers[i].size(); j++) {
+			cout << random_numbers[i][j] << " ";
+		}
+		cout << endl;
+	}
+
+	exit(1);
+	#endif
+}
+
+} // namespace cc
@@ -0,0 +1,189 @@
+#pragma once
+
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <cstdint>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace cc
+{
+
+const int COUNTER_COUNT = 4;
+
+inline const char* counter_name(int counter)
+{
+	static const char* names[COUNTER_COUNT] = {"cycles", "instructions", "llc_misses", "dtlb_misses"};
+	return names[counter];
+}
+
+/**
+ * Hardware counters of the threads of the process, read with perf_event_open (Linux only, no external tool).
+ * Every OpenMP thread opens its own counters, user space only: a read sums the counters of all the threads,
+ * scaled when the kernel multiplexed them. The counters that cannot be opened (no permission, see
+ * /proc/sys/kernel/perf_event_paranoid, or no PMU, as in most virtual machines) are unavailable and read as zero
+ */
+class PerfCounters
+{
+	bool enabled_ = false;
+	bool available_[COUNTER_COUNT] = {};
+	string reasons_[COUNTER_COUNT];
+	// File descriptors of every thread, -1 when the counter is unavailable
+	vector<int> fds_;
+	int threads_ = 0;
+
+public:
+	static PerfCounters& instance()
+	{
+		static PerfCounters counters;
+		return counters;
+	}
+
+	~PerfCounters() { disable(); }
+
+	bool enabled() const { return enabled_; }
+	bool available(int counter) const { return available_[counter]; }
+	// Why the counter is unavailable
+	const string& reason(int counter) const { return reasons_[counter]; }
+
+	/**
+	 * Open the counters on the threads of the next parallel regions
+	 * @return false when no counter is available
+	 */
+	bool enable()
+	{
+		disable();
+		#ifdef __linux__
+		threads_ = omp_get_max_threads();
+		fds_.assign(threads_ * COUNTER_COUNT, -1);
+		vector<int> errors(threads_ * COUNTER_COUNT, 0);
+
+		// Every thread opens the counters of itself
+		#pragma omp parallel num_threads(threads_)
+		{
+			int thread = omp_get_thread_num();
+			for (int c = 0; c < COUNTER_COUNT; c++)
+			{
+				perf_event_attr attr = attributes(c);
+				long fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+				if (fd >= 0)
+					fds_[thread * COUNTER_COUNT + c] = fd;
+				else
+					errors[thread * COUNTER_COUNT + c] = errno;
+			}
+		}
+
+		// A counter is available when all the threads opened it
+		bool any = false;
+		for (int c = 0; c < COUNTER_COUNT; c++)
+		{
+			available_[c] = true;
+			for (int t = 0; t < threads_; t++)
+				if (fds_[t * COUNTER_COUNT + c] < 0)
+				{
+					available_[c] = false;
+					reasons_[c] = reason_of(errors[t * COUNTER_COUNT + c]);
+				}
+			any = any || available_[c];
+		}
+		if (!any)
+		{
+			disable();
+			return false;
+		}
+		enabled_ = true;
+		return true;
+		#else
+		for (int c = 0; c < COUNTER_COUNT; c++)
+			reasons_[c] = "not Linux";
+		return false;
+		#endif
+	}
+
+	void disable()
+	{
+		#ifdef __linux__
+		for (int fd : fds_)
+			if (fd >= 0)
+				close(fd);
+		#endif
+		fds_.clear();
+		for (int c = 0; c < COUNTER_COUNT; c++)
+			available_[c] = false;
+		enabled_ = false;
+	}
+
+	// Current values, summed over the threads
+	void read(double values[COUNTER_COUNT]) const
+	{
+		for (int c = 0; c < COUNTER_COUNT; c++)
+			values[c] = 0;
+		#ifdef __linux__
+		for (int t = 0; t < threads_ && enabled_; t++)
+			for (int c = 0; c < COUNTER_COUNT; c++)
+			{
+				int fd = fds_[t * COUNTER_COUNT + c];
+				// Value, time enabled, time running
+				uint64_t data[3];
+				if (!available_[c] || ::read(fd, data, sizeof(data)) != sizeof(data))
+					continue;
+				values[c] += data[2] > 0 ? double(data[0]) * data[1] / data[2] : 0;
+			}
+		#endif
+	}
+
+private:
+	static string reason_of(int error)
+	{
+		if (error == EACCES || error == EPERM)
+			return "no permission, see /proc/sys/kernel/perf_event_paranoid";
+		if (error == ENOENT || error == EOPNOTSUPP)
+			return "not supported by the processor or the hypervisor";
+		return strerror(error);
+	}
+
+	#ifdef __linux__
+	static perf_event_attr attributes(int counter)
+	{
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		switch (counter)
+		{
+		case 0:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			break;
+		case 1:
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+			break;
+		case 2:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		default:
+			attr.type = PERF_TYPE_HW_CACHE;
+			attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			break;
+		}
+		return attr;
+	}
+	#endif
+};
+
+} // namespace cc
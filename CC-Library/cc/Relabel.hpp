@@ -0,0 +1,269 @@
+#pragma once
+
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <string>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+//GNU parallel mode: the sorts use the OpenMP threads
+#include <parallel/algorithm>
+//Custom libraries
+#include "Edge.hpp"
+
+using namespace std;
+
+/*
+ * Locality pre-pass: the vertices are renumbered so that the endpoints of the edges are close in the label
+ * arrays of the engines, then the edges are rewritten with the new numbers and sorted.
+ *	degree		decreasing degree: the hubs share the first cache lines
+ *	bfs			breadth-first order of every component
+ *	rcm			reverse Cuthill-McKee: breadth-first from a vertex of minimum degree, the children of a vertex by
+ *				increasing degree, the whole order reversed
+ * The labels computed on the renumbered graph are mapped back to the original numbers by restore_labels.
+ */
+namespace cc
+{
+
+enum class VertexOrder
+{
+	NONE,
+	DEGREE,
+	BFS,
+	RCM
+};
+
+inline bool parse_vertex_order(const string& name, VertexOrder& order)
+{
+	if (name == "none")
+		order = VertexOrder::NONE;
+	else if (name == "degree")
+		order = VertexOrder::DEGREE;
+	else if (name == "bfs")
+		order = VertexOrder::BFS;
+	else if (name == "rcm")
+		order = VertexOrder::RCM;
+	else
+		return false;
+	return true;
+}
+
+inline const char* vertex_order_name(VertexOrder order)
+{
+	static const char* names[] = {"none", "degree", "bfs", "rcm"};
+	return names[(int)order];
+}
+
+// Undirected graph in compressed sparse rows: the neighbors of v are neighbors[offsets[v], offsets[v + 1])
+struct Adjacency
+{
+	vector<uint64_t> offsets;
+	vector<uint32_t> neighbors;
+
+	uint32_t vertexCount() const { return offsets.size() - 1; }
+	uint64_t degree(uint32_t v) const { return offsets[v + 1] - offsets[v]; }
+};
+
+inline Adjacency build_adjacency(uint32_t vertex_count, const vector<Edge>& edges)
+{
+	Adjacency adjacency;
+	adjacency.offsets.assign(vertex_count + 1, 0);
+	uint64_t* offsets = adjacency.offsets.data();
+
+	// Degrees, shifted by one for the prefix sum
+	#pragma omp parallel for
+	for (size_t i = 0; i < edges.size(); i++)
+	{
+		#pragma omp atomic
+		offsets[edges[i].from + 1]++;
+		#pragma omp atomic
+		offsets[edges[i].to + 1]++;
+	}
+	partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+	// Every endpoint takes the next free slot of the other one (the order of a list depends on the threads)
+	vector<uint64_t> next(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+	adjacency.neighbors.resize(2 * edges.size());
+	uint32_t* neighbors = adjacency.neighbors.data();
+	#pragma omp parallel for
+	for (size_t i = 0; i < edges.size(); i++)
+	{
+		uint64_t slot;
+		#pragma omp atomic capture
+		slot = next[edges[i].from]++;
+		neighbors[slot] = edges[i].to;
+		#pragma omp atomic capture
+		slot = next[edges[i].to]++;
+		neighbors[slot] = edges[i].from;
+	}
+
+	return adjacency;
+}
+
+/**
+ * Breadth-first order of all the vertices: a traversal from every start that is not reached yet, in the order of starts.
+ * The levels are expanded in parallel. A vertex reached by several vertices of the level has the first of them as parent,
+ * the next level is sorted by parent, then by degree when by_degree, then by number: the order does not depend on the threads
+ * @param starts every vertex, in the order in which they start a traversal
+ * @return the vertices in the order of the traversals
+ */
+inline vector<uint32_t> breadth_first_order(const Adjacency& adjacency, const vector<uint32_t>& starts, bool by_degree)
+{
+	uint32_t vertex_count = adjacency.vertexCount();
+	// Below this size a level is expanded by the calling thread alone
+	const size_t PARALLEL_LEVEL = 1024;
+	// Position of the parent in the order + 1, 0 for the starts, NOT_REACHED before
+	const uint32_t NOT_REACHED = UINT32_MAX;
+	vector<atomic<uint32_t>> parent(vertex_count);
+	#pragma omp parallel for
+	for (uint32_t v = 0; v < vertex_count; v++)
+		parent[v].store(NOT_REACHED, memory_order_relaxed);
+
+	vector<uint32_t> order;
+	order.reserve(vertex_count);
+	vector<vector<uint32_t>> reached(omp_get_max_threads());
+
+	auto level_order = [&](uint32_t a, uint32_t b)
+	{
+		uint32_t parent_a = parent[a].load(memory_order_relaxed), parent_b = parent[b].load(memory_order_relaxed);
+		if (parent_a != parent_b)
+			return parent_a < parent_b;
+		if (by_degree && adjacency.degree(a) != adjacency.degree(b))
+			return adjacency.degree(a) < adjacency.degree(b);
+		return a < b;
+	};
+
+	for (uint32_t start : starts)
+	{
+		if (parent[start].load(memory_order_relaxed) != NOT_REACHED)
+			continue;
+		parent[start].store(0, memory_order_relaxed);
+		order.push_back(start);
+
+		size_t level_begin = order.size() - 1;
+		while (level_begin < order.size())
+		{
+			size_t level_end = order.size();
+
+			#pragma omp parallel if(level_end - level_begin >= PARALLEL_LEVEL)
+			{
+				// Every vertex of the next level takes the first parent of the level: the vertices of the previous
+				// levels have a parent before level_begin, the ones reached by this level a parent after it
+				#pragma omp for schedule(static)
+				for (size_t p = level_begin; p < level_end; p++)
+				{
+					uint32_t v = order[p], mine = p + 1;
+					for (uint64_t j = adjacency.offsets[v]; j < adjacency.offsets[v + 1]; j++)
+					{
+						atomic<uint32_t>& current = parent[adjacency.neighbors[j]];
+						uint32_t value = current.load(memory_order_relaxed);
+						while (value > level_begin && mine < value && !current.compare_exchange_weak(value, mine, memory_order_relaxed))
+							;
+					}
+				}
+
+				// The parents list their children (twice with parallel edges)
+				vector<uint32_t>& local = reached[omp_get_thread_num()];
+				#pragma omp for schedule(static)
+				for (size_t p = level_begin; p < level_end; p++)
+				{
+					uint32_t v = order[p];
+					for (uint64_t j = adjacency.offsets[v]; j < adjacency.offsets[v + 1]; j++)
+						if (parent[adjacency.neighbors[j]].load(memory_order_relaxed) == p + 1)
+							local.push_back(adjacency.neighbors[j]);
+				}
+			}
+
+			for (vector<uint32_t>& local : reached)
+			{
+				order.insert(order.end(), local.begin(), local.end());
+				local.clear();
+			}
+			__gnu_parallel::sort(order.begin() + level_end, order.end(), level_order);
+			order.erase(unique(order.begin() + level_end, order.end()), order.end());
+
+			level_begin = level_end;
+		}
+	}
+
+	return order;
+}
+
+/**
+ * New numbering of the vertices
+ * @return the vertices (original numbers) in the new order: order[new] = original
+ */
+inline vector<uint32_t> compute_vertex_order(VertexOrder kind, uint32_t vertex_count, const vector<Edge>& edges)
+{
+	vector<uint32_t> order(vertex_count);
+	#pragma omp parallel for
+	for (uint32_t v = 0; v < vertex_count; v++)
+		order[v] = v;
+	if (kind == VertexOrder::NONE)
+		return order;
+
+	Adjacency adjacency = build_adjacency(vertex_count, edges);
+	switch (kind)
+	{
+	case VertexOrder::DEGREE:
+		__gnu_parallel::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+			{ return adjacency.degree(a) != adjacency.degree(b) ? adjacency.degree(a) > adjacency.degree(b) : a < b; });
+		break;
+	case VertexOrder::BFS:
+		order = breadth_first_order(adjacency, order, false);
+		break;
+	default:
+		// Every component starts from one of its vertices of minimum degree
+		__gnu_parallel::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+			{ return adjacency.degree(a) != adjacency.degree(b) ? adjacency.degree(a) < adjacency.degree(b) : a < b; });
+		order = breadth_first_order(adjacency, order, true);
+		reverse(order.begin(), order.end());
+		break;
+	}
+	return order;
+}
+
+/**
+ * Renumber the vertices of the graph: the edges are rewritten with the new numbers, normalized and sorted
+ * @return order[new] = original, for restore_labels
+ */
+inline vector<uint32_t> relabel_graph(VertexOrder kind, uint32_t vertex_count, vector<Edge>& edges)
+{
+	vector<uint32_t> order = compute_vertex_order(kind, vertex_count, edges);
+	if (kind == VertexOrder::NONE)
+		return order;
+
+	vector<uint32_t> new_number(vertex_count);
+	#pragma omp parallel for
+	for (uint32_t i = 0; i < vertex_count; i++)
+		new_number[order[i]] = i;
+
+	#pragma omp parallel for
+	for (size_t i = 0; i < edges.size(); i++)
+	{
+		edges[i] = Edge{new_number[edges[i].from], new_number[edges[i].to]};
+		edges[i].normalize();
+	}
+	__gnu_parallel::sort(edges.begin(), edges.end());
+
+	return order;
+}
+
+/**
+ * Labels of the original vertices from the labels of the renumbered graph: the label of every vertex is
+ * the original number of the representative of its component
+ * @param order returned by relabel_graph
+ */
+inline void restore_labels(vector<uint32_t>& labels, const vector<uint32_t>& order)
+{
+	vector<uint32_t> original(labels.size());
+	#pragma omp parallel for
+	for (uint32_t i = 0; i < labels.size(); i++)
+		original[order[i]] = order[labels[i]];
+	labels.swap(original);
+}
+
+} // namespace cc
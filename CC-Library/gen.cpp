@@ -0,0 +1,69 @@
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <string>
+//Custom libraries
+#include "cc/Edge.hpp"
+#include "cc/Generators.hpp"
+#include "cc/GraphFiles.hpp"
+
+using namespace std;
+
+// Write a synthetic graph in the text format, or in the binary format if the output file ends in .bin
+int main(int argc, char* argv[])
+{
+	cc::GraphSpec spec;
+	bool valid_options = argc >= 3 && cc::parse_graph_spec(argv[1], spec);
+	for (int i = 3; i < argc && valid_options; i++)
+	{
+		string option = argv[i];
+		if (option.compare(0, 7, "--seed=") == 0)
+			spec.seed = strtoull(option.c_str() + 7, nullptr, 10);
+		else if (option.compare(0, 10, "--threads=") == 0 && atoi(option.c_str() + 10) > 0)
+			omp_set_num_threads(atoi(option.c_str() + 10));
+		else
+		{
+			cout << "Unknown option: " << option << endl;
+			valid_options = false;
+		}
+	}
+
+	// cc and the text format count the edges with uint32_t
+	if (valid_options && cc::graph_edge_count(spec) > cc::MAX_EDGE_COUNT)
+	{
+		cout << argv[1] << " has " << cc::graph_edge_count(spec) << " edges, the engines take at most " << cc::MAX_EDGE_COUNT << endl;
+		valid_options = false;
+	}
+
+	if (!valid_options)
+	{
+		cout << "Usage: gen SPEC OUTPUT_FILE [--seed=N] [--threads=N]" << endl;
+		cout << "SPEC: rmat:SCALE:DEGREE | er:N:M | grid2d:X:Y | grid3d:X:Y:Z | path:N | islands:COUNT:SIZE" << endl;
+		return 1;
+	}
+
+	double start_time = omp_get_wtime();
+	vector<Edge> edges;
+	uint32_t vertex_count = cc::generate_graph(spec, edges);
+	double generate_time = omp_get_wtime() - start_time;
+
+	start_time = omp_get_wtime();
+	string output = argv[2];
+	if (cc::binary_graph_file(output))
+		cc::write_binary_graph(output, vertex_count, edges);
+	else
+		cc::write_text_graph(output, vertex_count, edges);
+	double write_time = omp_get_wtime() - start_time;
+
+	cout << fixed;
+	cout << "Graph: " << argv[1] << " Seed: " << spec.seed << endl;
+	cout << "Number of vertices: " << vertex_count << endl;
+	cout << "Number of edges: " << edges.size() << endl;
+	cout << "Generation time: " << generate_time << " seconds" << endl;
+	cout << "Write time: " << write_time << " seconds" << endl;
+
+	return 0;
+}
@@ -0,0 +1 @@
+#include "DisjointSets.hpp"
\ No newline at end of file
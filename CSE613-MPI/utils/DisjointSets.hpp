@@ -0,0 +1,4 @@
+#pragma once
+
+// Shared by all the projects: one copy in the CC library
+#include "../../CC-Library/cc/DisjointSets.hpp"
@@ -0,0 +1,351 @@
+#include "mpi_parallel_cc.hpp"
+//Standard libraries
+#include <iostream>
+#include <numeric>
+#include <string>
+//Custom libraries
+#include "MPIEdge.hpp"
+#include "../../CC-Library/cc/Instrumentation.hpp"
+
+#define DEBUG 0
+
+vector<uint32_t>& master(int rank, int group_size, uint32_t nNodes, uint32_t nEdges, vector<Edge>& edges, vector<uint32_t>& labels, int* iteration, const CCOptions& options, NodeSharedArray* shared_labels, const ProcessGrid* grid, PhaseWaitTimes& times) 
+{
+	// Increment the iteration
+	(*iteration)++;
+		
+	{
+		string str = "Iteration - " + to_string(*iteration) + " Number of edges: " + to_string(edges.size()) + "\n";
+    	cout << str;
+	}
+
+	//---------------------- Send a slice of the edges to each process ----------------------
+
+	// Sort the edges by source range: every process will touch a compact window of labels
+	if(options.source_partition && nEdges >= options.serial_cutoff)
+		partition_edges_by_source(group_size, nNodes, edges);
+
+	// Calculate the number of edges to send to each processor (by grid block with the 2D decomposition)
+	vector<int> edges_per_proc = grid != nullptr ? partition_edges_by_grid(*grid, nNodes, edges) : calculate_edges_per_processor(group_size, edges);
+	// Calculate the displacements for the scatterv function
+	vector<int> displacements = calculate_displacements(group_size, edges_per_proc);
+
+	CC_ROUND(nEdges, cc::count_roots(shared_labels != nullptr ? shared_labels->data() : labels.data(), nNodes));
+	CC_PHASE_START(SCATTER);
+	double phase_start = MPI_Wtime();
+
+	// Send the number of total edges
+	MPI_Bcast(&nEdges, 1, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+
+	// Send the number of local edges
+	uint32_t nEdges_local;
+	MPI_Scatter(edges_per_proc.data(), 1, MPI_UINT32_T, &nEdges_local, 1, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+	
+	// Base case. Below the serial cutoff the master finishes alone with the union-find and the other processes exit
+	bool serial_finish = nEdges < options.serial_cutoff;
+	if(nEdges == 0 || nNodes == 0 || serial_finish) {
+		times.scatter += MPI_Wtime() - phase_start;
+		CC_PHASE_STOP(SCATTER);
+		if(nEdges > 0 && serial_finish) {
+			CC_PHASE(CONTRACT);
+			double serial_start = MPI_Wtime();
+			finish_with_union_find(nNodes, edges, shared_labels != nullptr ? shared_labels->data() : labels.data());
+			string str = "Serial cutoff: " + to_string(nEdges) + " edges finished with the union-find in " + to_string(MPI_Wtime() - serial_start) + " seconds\n";
+			cout << str;
+		}
+		// Copy back the labels from the memory of the node
+		if(shared_labels != nullptr)
+			copy(shared_labels->data(), shared_labels->data() + nNodes, labels.begin());
+		return labels;
+	}
+
+	// Allocate memory for slice of edges
+	vector<Edge> edges_slice(nEdges_local);
+
+	// Send a slice of the edges to each process
+	MPI_Scatterv(edges.data(), edges_per_proc.data(), displacements.data(), MPIEdge::edge_type, edges_slice.data(), nEdges_local, MPIEdge::edge_type, 0, MPI_COMM_WORLD);
+
+	times.scatter += MPI_Wtime() - phase_start;
+	CC_PHASE_STOP(SCATTER);
+	CC_PHASE_BYTES(SCATTER, nEdges_local * sizeof(Edge));
+
+	if(options.partition_stats)
+		log_partition_stats(rank, group_size, edges_slice);
+
+	// Labels used in this round: the private copy or the one shared by the node
+	uint32_t* round_labels = shared_labels != nullptr ? shared_labels->data() : labels.data();
+
+	// Broadcast the labels (the pipelined and the 2D rounds do not need them to hook: the master owns the up-to-date labels)
+	CC_PHASE_START(BCAST);
+	phase_start = MPI_Wtime();
+	if(shared_labels != nullptr)
+		shared_labels->broadcast(nNodes);
+	else if(options.pipeline_chunks == 0 && grid == nullptr)
+		MPI_Bcast(labels.data(), nNodes, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+	times.bcast += MPI_Wtime() - phase_start;
+	CC_PHASE_STOP(BCAST);
+	if(shared_labels != nullptr || (options.pipeline_chunks == 0 && grid == nullptr))
+		CC_PHASE_BYTES(BCAST, nNodes * sizeof(uint32_t));
+
+	#if DEBUG
+	{
+		string str = "";
+		str += "MASTER Rank: " + to_string(rank) + " Edges: ";
+		// Print the received edges
+		for (uint32_t i = 0; i < nEdges_local; i++)
+			str += "(" + to_string(edges_slice[i].from) + "," + to_string(edges_slice[i].to) + ") ";
+		str += "\n";
+		cout << str;
+	}
+	#endif
+
+	// ---------------------- Hook nodes ----------------------
+
+	// Hook nodes and merge the labels
+	// The pipelined and the 2D rounds merge the labels while they hook: their reduction is timed with the hook
+	CC_PHASE_START(HOOK);
+	uint32_t chunk_size = options.pipeline_chunks > 0 ? calculate_chunk_size(nNodes, options.pipeline_chunks) : 0;
+	if(grid != nullptr)
+		grid_hook_and_merge(rank, nNodes, *grid, edges_slice, labels, times);
+	else if(options.pipeline_chunks > 0) {
+		vector<uint32_t> buckets = bucket_edges_by_chunk(edges_slice, chunk_size, options.pipeline_chunks, false);
+		pipelined_hook_and_reduce(rank, nNodes, edges_slice, buckets, chunk_size, round_labels, times);
+	}
+	else if(shared_labels != nullptr) {
+		hook_nodes_shared(edges_slice, round_labels);
+		CC_PHASE_STOP(HOOK);
+		CC_PHASE(REDUCE);
+		phase_start = MPI_Wtime();
+		shared_labels->reduceMax(nNodes);
+		times.reduce += MPI_Wtime() - phase_start;
+		CC_PHASE_BYTES(REDUCE, nNodes * sizeof(uint32_t));
+	}
+	else {
+		hook_nodes(edges_slice, labels);
+		CC_PHASE_STOP(HOOK);
+		CC_PHASE(REDUCE);
+		phase_start = MPI_Wtime();
+		MPI_Reduce(MPI_IN_PLACE, labels.data(), nNodes, MPI_UINT32_T, MPI_MAX, 0, MPI_COMM_WORLD);
+		times.reduce += MPI_Wtime() - phase_start;
+		CC_PHASE_BYTES(REDUCE, nNodes * sizeof(uint32_t));
+	}
+	CC_PHASE_STOP(HOOK);
+	
+	// ---------------------- Find the roots ----------------------
+
+	// Find the roots for every node
+	{
+		CC_PHASE(FIND_ROOTS);
+		find_roots(nNodes, round_labels);
+	}
+
+	// ---------------------- Create the next edges ----------------------
+
+	vector<Edge> nextEdges_local;
+	if(options.pipeline_chunks > 0) {
+		// Broadcast the labels and compute the next edges chunk by chunk
+		CC_PHASE(COMPUTE_NEXT_EDGES);
+		vector<uint32_t> buckets = bucket_edges_by_chunk(edges_slice, chunk_size, options.pipeline_chunks, true);
+		nextEdges_local = pipelined_bcast_and_next_edges(nNodes, edges_slice, buckets, chunk_size, round_labels, times);
+	}
+	else {
+		// Broadcast the labels
+		CC_PHASE_START(BCAST);
+		phase_start = MPI_Wtime();
+		if(grid != nullptr)
+			grid_bcast_roots(rank, nNodes, *grid, labels);
+		else if(shared_labels != nullptr)
+			shared_labels->broadcast(nNodes);
+		else
+			MPI_Bcast(labels.data(), nNodes, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+		times.bcast += MPI_Wtime() - phase_start;
+		CC_PHASE_STOP(BCAST);
+		CC_PHASE_BYTES(BCAST, nNodes * sizeof(uint32_t));
+
+		// Compute the next edges
+		CC_PHASE(COMPUTE_NEXT_EDGES);
+		nextEdges_local = compute_next_edges(edges_slice, round_labels);
+		CC_PHASE_BYTES(COMPUTE_NEXT_EDGES, nextEdges_local.size() * sizeof(Edge));
+	}
+
+	// ---------------------- Gather a slice of the next edges from each process ----------------------
+
+	CC_PHASE_START(GATHER);
+	phase_start = MPI_Wtime();
+
+	// Receive the number of local edges
+	vector<int> next_edges_per_proc(group_size);
+	uint32_t next_nEdges_local = nextEdges_local.size();
+	// Gather the number of local edges
+	MPI_Gather(&next_nEdges_local, 1, MPI_UINT32_T, next_edges_per_proc.data(), 1, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+
+	// Allocate memory for the slice of next edges
+	vector<Edge> next_edges(accumulate(next_edges_per_proc.begin(), next_edges_per_proc.end(), 0));
+	// Calculate the displacements 
+	vector<int> next_displacements = calculate_displacements(group_size, next_edges_per_proc);
+
+	// Gather the slice of next edges from each process
+	MPI_Gatherv(nextEdges_local.data(), next_nEdges_local, MPIEdge::edge_type, next_edges.data(), next_edges_per_proc.data(), next_displacements.data(), MPIEdge::edge_type, 0, MPI_COMM_WORLD);
+
+	times.gather += MPI_Wtime() - phase_start;
+	CC_PHASE_STOP(GATHER);
+	CC_PHASE_BYTES(GATHER, next_nEdges_local * sizeof(Edge));
+
+	// ---------------------- Recursively call the function ----------------------
+	
+	return master(rank, group_size, nNodes, next_edges.size(), next_edges, labels, iteration, options, shared_labels, grid, times);
+}
+
+void slave(int rank, int group_size, uint32_t nNodes, const CCOptions& options, NodeSharedArray* shared_labels, const ProcessGrid* grid, PhaseWaitTimes& times)
+{
+	// ---------------------- Receive the data ----------------------
+
+	CC_ROUND(0, 0);
+	CC_PHASE_START(SCATTER);
+	double phase_start = MPI_Wtime();
+
+	// Receive the number of total edges
+	uint32_t nEdges;
+	MPI_Bcast(&nEdges, 1, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+	CC_ROUND_EDGES(nEdges);
+
+	// Receive the number of local edges
+	uint32_t nEdges_local;
+	MPI_Scatter(nullptr, 1, MPI_UINT32_T, &nEdges_local, 1, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+
+	// Base case. Below the serial cutoff the master finishes alone
+	if(nEdges == 0 || nNodes == 0 || nEdges < options.serial_cutoff) {
+		times.scatter += MPI_Wtime() - phase_start;
+		return;
+	}
+
+	// Allocate memory for the slice of edges
+	vector<Edge> edges_slice(nEdges_local);
+
+	// Receive the slice of edges
+	MPI_Scatterv(nullptr, nullptr, nullptr, MPIEdge::edge_type, edges_slice.data(), nEdges_local, MPIEdge::edge_type, 0, MPI_COMM_WORLD);
+
+	times.scatter += MPI_Wtime() - phase_start;
+	CC_PHASE_STOP(SCATTER);
+	CC_PHASE_BYTES(SCATTER, nEdges_local * sizeof(Edge));
+
+	if(options.partition_stats)
+		log_partition_stats(rank, group_size, edges_slice);
+	
+	// Allocate memory for the labels, unless they are shared by the node
+	// In the pipelined and the 2D rounds they start at 0: the master merges them with MPI_MAX into the up-to-date labels
+	vector<uint32_t> labels(shared_labels != nullptr ? 0 : nNodes);
+	uint32_t* round_labels = shared_labels != nullptr ? shared_labels->data() : labels.data();
+	// Receive the labels
+	CC_PHASE_START(BCAST);
+	phase_start = MPI_Wtime();
+	if(shared_labels != nullptr)
+		shared_labels->broadcast(nNodes);
+	else if(options.pipeline_chunks == 0 && grid == nullptr)
+		MPI_Bcast(labels.data(), nNodes, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+	times.bcast += MPI_Wtime() - phase_start;
+	CC_PHASE_STOP(BCAST);
+	if(shared_labels != nullptr || (options.pipeline_chunks == 0 && grid == nullptr))
+		CC_PHASE_BYTES(BCAST, nNodes * sizeof(uint32_t));
+
+	#if DEBUG
+	{
+		string str = "";
+		str += "SLAVE Rank: " + to_string(1) + " Edges: ";
+		// Print the received edges
+		for (uint32_t i = 0; i < nEdges_local; i++)
+			str += "(" + to_string(edges_slice[i].from) + "," + to_string(edges_slice[i].to) + ") ";
+		str += "\n";
+		cout << str;
+	}
+	#endif
+
+	// ---------------------- Choose the hook direction ----------------------
+
+	// Choose the hook direction and merge the labels
+	// The pipelined and the 2D rounds merge the labels while they hook: their reduction is timed with the hook
+	CC_PHASE_START(HOOK);
+	uint32_t chunk_size = options.pipeline_chunks > 0 ? calculate_chunk_size(nNodes, options.pipeline_chunks) : 0;
+	if(grid != nullptr)
+		grid_hook_and_merge(rank, nNodes, *grid, edges_slice, labels, times);
+	else if(options.pipeline_chunks > 0) {
+		vector<uint32_t> buckets = bucket_edges_by_chunk(edges_slice, chunk_size, options.pipeline_chunks, false);
+		pipelined_hook_and_reduce(rank, nNodes, edges_slice, buckets, chunk_size, round_labels, times);
+	}
+	else if(shared_labels != nullptr) {
+		hook_nodes_shared(edges_slice, round_labels);
+		CC_PHASE_STOP(HOOK);
+		CC_PHASE(REDUCE);
+		phase_start = MPI_Wtime();
+		shared_labels->reduceMax(nNodes);
+		times.reduce += MPI_Wtime() - phase_start;
+		CC_PHASE_BYTES(REDUCE, nNodes * sizeof(uint32_t));
+	}
+	else {
+		hook_nodes(edges_slice, labels);
+		CC_PHASE_STOP(HOOK);
+		CC_PHASE(REDUCE);
+		phase_start = MPI_Wtime();
+		MPI_Reduce(labels.data(), nullptr, nNodes, MPI_UINT32_T, MPI_MAX, 0, MPI_COMM_WORLD);
+		times.reduce += MPI_Wtime() - phase_start;
+		CC_PHASE_BYTES(REDUCE, nNodes * sizeof(uint32_t));
+	}
+	CC_PHASE_STOP(HOOK);
+
+	// -------------------------------- Find the roots --------------------------------
+
+	// Wait the master to find the roots
+
+	// ---------------------- Create the next edges ----------------------
+
+	vector<Edge> nextEdges_local;
+	if(options.pipeline_chunks > 0) {
+		// Receive the labels and compute the next edges chunk by chunk
+		CC_PHASE(COMPUTE_NEXT_EDGES);
+		vector<uint32_t> buckets = bucket_edges_by_chunk(edges_slice, chunk_size, options.pipeline_chunks, true);
+		nextEdges_local = pipelined_bcast_and_next_edges(nNodes, edges_slice, buckets, chunk_size, round_labels, times);
+	}
+	else {
+		// Broadcast the labels
+		CC_PHASE_START(BCAST);
+		phase_start = MPI_Wtime();
+		if(grid != nullptr)
+			grid_bcast_roots(rank, nNodes, *grid, labels);
+		else if(shared_labels != nullptr)
+			shared_labels->broadcast(nNodes);
+		else
+			MPI_Bcast(labels.data(), nNodes, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+		times.bcast += MPI_Wtime() - phase_start;
+		CC_PHASE_STOP(BCAST);
+		CC_PHASE_BYTES(BCAST, nNodes * sizeof(uint32_t));
+
+		// Compute the next edges
+		CC_PHASE(COMPUTE_NEXT_EDGES);
+		nextEdges_local = compute_next_edges(edges_slice, round_labels);
+		CC_PHASE_BYTES(COMPUTE_NEXT_EDGES, nextEdges_local.size() * sizeof(Edge));
+	}
+
+	// ---------------------- Send the slice of the next edges ----------------------
+
+	CC_PHASE_START(GATHER);
+	phase_start = MPI_Wtime();
+
+	// Send the number of local edges
+
+	uint32_t next_nEdges_local = nextEdges_local.size();
+	// Gather the number of local edges
+	MPI_Gather(&next_nEdges_local, 1, MPI_UINT32_T, nullptr, 1, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+
+
+	// Send the slice of next edges
+	MPI_Gatherv(nextEdges_local.data(), next_nEdges_local, MPIEdge::edge_type, nullptr, nullptr, nullptr, MPIEdge::edge_type, 0, MPI_COMM_WORLD);
+
+	times.gather += MPI_Wtime() - phase_start;
+	CC_PHASE_STOP(GATHER);
+	CC_PHASE_BYTES(GATHER, next_nEdges_local * sizeof(Edge));
+
+	// ---------------------- Recursively call the function ----------------------
+	
+	return slave(rank, group_size, nNodes, options, shared_labels, grid, times);
+
+}
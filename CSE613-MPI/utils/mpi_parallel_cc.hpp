@@ -0,0 +1,17 @@
+#pragma once
+
+#include <mpi.h>
+//Standard libraries
+#include <vector>
+#include <cstdint>
+//Custom libraries
+#include "Edge.hpp"
+#include "NodeSharedArray.hpp"
+#include "mpi_parallel_cc_utils.hpp"
+
+using namespace std;
+
+// Rounds of the master: it owns the edges and the up-to-date labels, the rounds end when no edge is left
+vector<uint32_t>& master(int rank, int group_size, uint32_t nNodes, uint32_t nEdges, vector<Edge>& edges, vector<uint32_t>& labels, int* iteration, const CCOptions& options, NodeSharedArray* shared_labels, const ProcessGrid* grid, PhaseWaitTimes& times);
+// Rounds of the other processes: they follow the collectives of the master
+void slave(int rank, int group_size, uint32_t nNodes, const CCOptions& options, NodeSharedArray* shared_labels, const ProcessGrid* grid, PhaseWaitTimes& times);
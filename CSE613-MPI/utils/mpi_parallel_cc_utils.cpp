@@ -1,4 +1,81 @@
 #include "mpi_parallel_cc_utils.hpp"
+#include "NodeSharedArray.hpp"
+#include "DisjointSets.hpp"
+#include "../../CC-Library/cc/Instrumentation.hpp"
+//Standard libraries
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <cmath>
+
+bool parse_options(int argc, char* argv[], CCOptions& options)
+{
+	if (argc < 2)
+		return false;
+
+	options.input_file = argv[1];
+
+	for (int i = 2; i < argc; i++)
+	{
+		string option = argv[i];
+
+		if (option == "--shared-labels")
+			options.shared_labels = true;
+		else if (option.compare(0, 11, "--pipeline=") == 0)
+			options.pipeline_chunks = atoi(option.c_str() + 11);
+		else if (option.compare(0, 16, "--serial-cutoff=") == 0)
+			options.serial_cutoff = strtoul(option.c_str() + 16, nullptr, 10);
+		else if (option == "--partition=source")
+			options.source_partition = true;
+		else if (option == "--partition=block")
+			options.source_partition = false;
+		else if (option == "--partition-stats")
+			options.partition_stats = true;
+		else if (option == "--grid")
+			options.grid = true;
+		else
+		{
+			cout << "Unknown option: " << option << endl;
+			return false;
+		}
+	}
+
+	if (options.pipeline_chunks < 0)
+	{
+		cout << "The number of pipeline chunks must be positive" << endl;
+		return false;
+	}
+
+	if (options.pipeline_chunks > 0 && options.shared_labels)
+	{
+		cout << "--pipeline and --shared-labels cannot be used together" << endl;
+		return false;
+	}
+
+	if (options.grid && (options.pipeline_chunks > 0 || options.shared_labels || options.source_partition))
+	{
+		cout << "--grid cannot be used with --pipeline, --shared-labels or --partition=source" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+void report_wait_times(int rank, int group_size, const PhaseWaitTimes& times)
+{
+	double local[4] = {times.scatter, times.reduce, times.bcast, times.gather};
+	double max[4], sum[4];
+
+	MPI_Reduce(local, max, 4, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+	MPI_Reduce(local, sum, 4, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+	if(rank == 0)
+	{
+		const char* phases[4] = {"scatter", "reduce", "bcast", "gather"};
+		for(int i = 0; i < 4; i++)
+			cout << "Wait time " << phases[i] << ": max " << max[i] << " s, avg " << sum[i] / group_size << " s" << endl;
+	}
+}
 
 vector<int> calculate_edges_per_processor(int group_size, const vector<Edge>& edges)
 {
@@ -14,6 +91,217 @@ vector<int> calculate_edges_per_processor(int group_size, const vector<Edge>& ed
 	return edges_per_processor;
 }
 
+void partition_edges_by_source(int group_size, uint32_t nNodes, vector<Edge>& edges)
+{
+	// The equal count slices of the sorted edges cover a few contiguous ranges each
+	uint32_t buckets = group_size * SOURCE_BUCKETS_PER_PROCESSOR;
+
+	// Count the edges of every source range
+	vector<uint32_t> offsets(buckets + 1, 0);
+	for(const Edge& edge : edges)
+		offsets[(uint64_t)edge.from * buckets / nNodes + 1]++;
+	partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+	// Place every edge in its source range
+	vector<Edge> sorted_edges(edges.size());
+	for(const Edge& edge : edges)
+		sorted_edges[offsets[(uint64_t)edge.from * buckets / nNodes]++] = edge;
+
+	edges.swap(sorted_edges);
+}
+
+void log_partition_stats(int rank, int group_size, const vector<Edge>& edges_slice)
+{
+	// Distinct vertices touched by the slice and window of the labels written by the hooking (the sources)
+	vector<uint32_t> vertices;
+	vertices.reserve(edges_slice.size() * 2);
+	uint32_t min_source = UINT32_MAX, max_source = 0;
+	for(const Edge& edge : edges_slice)
+	{
+		vertices.push_back(edge.from);
+		vertices.push_back(edge.to);
+		min_source = min(min_source, edge.from);
+		max_source = max(max_source, edge.from);
+	}
+	sort(vertices.begin(), vertices.end());
+	vertices.erase(unique(vertices.begin(), vertices.end()), vertices.end());
+
+	// Edges, touched vertices and width of the source window
+	uint32_t local_stats[3] = {(uint32_t)edges_slice.size(), (uint32_t)vertices.size(), edges_slice.empty() ? 0 : max_source - min_source + 1};
+	vector<uint32_t> stats(rank == 0 ? 3 * group_size : 0);
+	MPI_Gather(local_stats, 3, MPI_UINT32_T, stats.data(), 3, MPI_UINT32_T, 0, MPI_COMM_WORLD);
+
+	if(rank == 0)
+	{
+		string str = "";
+		uint64_t total_edges = 0;
+		uint32_t max_edges = 0;
+		for(int i = 0; i < group_size; i++)
+		{
+			str += "  Rank " + to_string(i) + ": edges " + to_string(stats[3 * i]) + " touched vertices " + to_string(stats[3 * i + 1]) + " source window " + to_string(stats[3 * i + 2]) + "\n";
+			total_edges += stats[3 * i];
+			max_edges = max(max_edges, stats[3 * i]);
+		}
+		double average_edges = double(total_edges) / group_size;
+		str = "Partition imbalance (max/avg edges): " + to_string(average_edges > 0 ? max_edges / average_edges : 1.0) + "\n" + str;
+		cout << str;
+	}
+}
+
+bool create_process_grid(int rank, int group_size, ProcessGrid& grid)
+{
+	grid.side = (int)round(sqrt((double)group_size));
+	if(grid.side * grid.side != group_size)
+		return false;
+
+	grid.row = rank / grid.side;
+	grid.column = rank % grid.side;
+
+	MPI_Comm_split(MPI_COMM_WORLD, grid.row, grid.column, &grid.row_comm);
+	MPI_Comm_split(MPI_COMM_WORLD, grid.column, grid.row, &grid.column_comm);
+
+	return true;
+}
+
+void free_process_grid(ProcessGrid& grid)
+{
+	MPI_Comm_free(&grid.row_comm);
+	MPI_Comm_free(&grid.column_comm);
+}
+
+// Vertices of the block of the grid: the vertices are distributed cyclically, because the roots gather on the highest ids
+static uint32_t grid_block_count(uint32_t nNodes, int side, int block)
+{
+	return (uint32_t)block < nNodes ? ((uint64_t)nNodes - block + side - 1) / side : 0;
+}
+
+// Copy the cyclic block of the labels in a contiguous buffer
+static void pack_grid_block(const vector<uint32_t>& labels, int side, int block, uint32_t* buffer)
+{
+	for(uint64_t i = block, k = 0; i < labels.size(); i += side, k++)
+		buffer[k] = labels[i];
+}
+
+// Copy a contiguous buffer in the cyclic block of the labels
+static void unpack_grid_block(const uint32_t* buffer, int side, int block, vector<uint32_t>& labels)
+{
+	for(uint64_t i = block, k = 0; i < labels.size(); i += side, k++)
+		labels[i] = buffer[k];
+}
+
+// Counts and displacements of the blocks of the grid in a packed array of labels
+static void grid_block_layout(uint32_t nNodes, int side, vector<int>& counts, vector<int>& displacements)
+{
+	counts.resize(side);
+	for(int i = 0; i < side; i++)
+		counts[i] = grid_block_count(nNodes, side, i);
+	displacements = calculate_displacements(side, counts);
+}
+
+vector<int> partition_edges_by_grid(const ProcessGrid& grid, uint32_t nNodes, vector<Edge>& edges)
+{
+	// Count the edges of every block of the grid: the block (i, j) belongs to the processor i * side + j
+	vector<int> edges_per_processor(grid.side * grid.side, 0);
+	for(const Edge& edge : edges)
+		edges_per_processor[edge.from % grid.side * grid.side + edge.to % grid.side]++;
+
+	// Place every edge in its block
+	vector<int> next_position = calculate_displacements(grid.side * grid.side, edges_per_processor);
+	vector<Edge> sorted_edges(edges.size());
+	for(const Edge& edge : edges)
+		sorted_edges[next_position[edge.from % grid.side * grid.side + edge.to % grid.side]++] = edge;
+
+	edges.swap(sorted_edges);
+
+	return edges_per_processor;
+}
+
+void grid_hook_and_merge(int rank, uint32_t nNodes, const ProcessGrid& grid, const vector<Edge>& edges, vector<uint32_t>& labels, PhaseWaitTimes& times)
+{
+	// The edges of the processor only write the labels of the block of its row
+	hook_nodes(edges, labels);
+
+	uint32_t count = grid_block_count(nNodes, grid.side, grid.row);
+	vector<uint32_t> block(count);
+	pack_grid_block(labels, grid.side, grid.row, block.data());
+
+	double start = MPI_Wtime();
+
+	// Merge the block of the row on the first column
+	if(grid.column == 0)
+		MPI_Reduce(MPI_IN_PLACE, block.data(), count, MPI_UINT32_T, MPI_MAX, 0, grid.row_comm);
+	else
+		MPI_Reduce(block.data(), nullptr, count, MPI_UINT32_T, MPI_MAX, 0, grid.row_comm);
+
+	// The first column sends the merged blocks to the master
+	if(grid.column == 0)
+	{
+		if(rank == 0)
+		{
+			vector<int> counts, displacements;
+			grid_block_layout(nNodes, grid.side, counts, displacements);
+
+			vector<uint32_t> merged(nNodes);
+			MPI_Gatherv(block.data(), count, MPI_UINT32_T, merged.data(), counts.data(), displacements.data(), MPI_UINT32_T, 0, grid.column_comm);
+
+			times.reduce += MPI_Wtime() - start;
+
+			// The other processors started from 0: merge with the labels of the master
+			for(int i = 0; i < grid.side; i++)
+			{
+				uint32_t* merged_block = merged.data() + displacements[i];
+				for(uint64_t v = i, k = 0; v < nNodes; v += grid.side, k++)
+					labels[v] = max(labels[v], merged_block[k]);
+			}
+			return;
+		}
+		else
+			MPI_Gatherv(block.data(), count, MPI_UINT32_T, nullptr, nullptr, nullptr, MPI_UINT32_T, 0, grid.column_comm);
+	}
+
+	times.reduce += MPI_Wtime() - start;
+}
+
+void grid_bcast_roots(int rank, uint32_t nNodes, const ProcessGrid& grid, vector<uint32_t>& labels)
+{
+	uint32_t row_count = grid_block_count(nNodes, grid.side, grid.row);
+	uint32_t column_count = grid_block_count(nNodes, grid.side, grid.column);
+	vector<uint32_t> row_block(row_count), column_block(column_count);
+
+	// The master sends the blocks to the first column
+	if(grid.column == 0)
+	{
+		if(rank == 0)
+		{
+			vector<int> counts, displacements;
+			grid_block_layout(nNodes, grid.side, counts, displacements);
+
+			vector<uint32_t> packed(nNodes);
+			for(int i = 0; i < grid.side; i++)
+				pack_grid_block(labels, grid.side, i, packed.data() + displacements[i]);
+
+			MPI_Scatterv(packed.data(), counts.data(), displacements.data(), MPI_UINT32_T, row_block.data(), row_count, MPI_UINT32_T, 0, grid.column_comm);
+		}
+		else
+			MPI_Scatterv(nullptr, nullptr, nullptr, MPI_UINT32_T, row_block.data(), row_count, MPI_UINT32_T, 0, grid.column_comm);
+	}
+
+	// The first column sends the block of the row along the row
+	MPI_Bcast(row_block.data(), row_count, MPI_UINT32_T, 0, grid.row_comm);
+
+	// The diagonal sends the block of the column along the column
+	if(grid.row == grid.column)
+		column_block = row_block;
+	MPI_Bcast(column_block.data(), column_count, MPI_UINT32_T, grid.column, grid.column_comm);
+
+	// The master already has every label
+	if(rank != 0)
+	{
+		unpack_grid_block(row_block.data(), grid.side, grid.row, labels);
+		unpack_grid_block(column_block.data(), grid.side, grid.column, labels);
+	}
+}
+
 vector<int> calculate_displacements(int group_size, const vector<int>& edges_per_processor)
 {
 	vector<int> displacements(group_size, 0);
@@ -34,13 +322,59 @@ void hook_nodes(const vector<Edge>& edges, vector<uint32_t>& labels)
 	}
 }
 
+void hook_nodes_shared(const vector<Edge>& edges, uint32_t* labels)
+{
+	for(uint32_t i = 0; i < edges.size(); i++)
+		NodeSharedArray::atomicMax(&labels[edges[i].from], edges[i].to);
+}
+
+void finish_with_union_find(uint32_t nNodes, const vector<Edge>& edges, uint32_t* labels)
+{
+	// Compact the endpoints of the remaining edges: only a few vertices are still active
+	unordered_map<uint32_t, uint32_t> compact_ids;
+	vector<uint32_t> vertices;
+	for(const Edge& edge : edges)
+	{
+		for(uint32_t vertex : {edge.from, edge.to})
+		{
+			if(compact_ids.insert(make_pair(vertex, (uint32_t)vertices.size())).second)
+				vertices.push_back(vertex);
+		}
+	}
+
+	//Create a disjoint set with the active vertices
+	DisjointSets<uint32_t> disjoint_set(vertices.size());
+
+	// Unify the vertices of each edge
+	for(const Edge& edge : edges)
+	{
+		uint32_t from_set = disjoint_set.find(compact_ids.at(edge.from));
+		uint32_t to_set = disjoint_set.find(compact_ids.at(edge.to));
+		if(from_set != to_set)
+			disjoint_set.unify(from_set, to_set);
+	}
+
+	// Hook every active root to the representative of its set
+	for(uint32_t i = 0; i < vertices.size(); i++)
+		labels[vertices[i]] = vertices[disjoint_set.find(i)];
+
+	// The other vertices point to an active root: one more pointer jumping
+	find_roots(nNodes, labels);
+}
+
 void find_roots(uint32_t nNodes, vector<uint32_t>& labels)
+{
+	find_roots(nNodes, labels.data());
+}
+
+void find_roots(uint32_t nNodes, uint32_t* labels)
 {
 	bool found = true;
 
 	while(found)
 	{
 		found = false;
+		CC_SWEEPS(1);
 
 		for(uint32_t i = 0; i < nNodes; i++)
 		{
@@ -55,14 +389,26 @@ void find_roots(uint32_t nNodes, vector<uint32_t>& labels)
 }
 
 vector<Edge> compute_next_edges(const vector<Edge>& edges, const vector<uint32_t>& labels)
+{
+	return compute_next_edges(edges, labels.data());
+}
+
+vector<Edge> compute_next_edges(const vector<Edge>& edges, const uint32_t* labels)
 {
 	vector<Edge> nextEdges;
 
+	append_next_edges(edges.data(), edges.data() + edges.size(), labels, nextEdges);
+
+	return nextEdges;
+}
+
+void append_next_edges(const Edge* begin, const Edge* end, const uint32_t* labels, vector<Edge>& nextEdges)
+{
 	// Compute the next edges
-	for(uint32_t i = 0; i < edges.size(); i++)
+	for(const Edge* current = begin; current != end; current++)
 	{
-		uint32_t from = edges[i].from;
-		uint32_t to = edges[i].to;
+		uint32_t from = current->from;
+		uint32_t to = current->to;
 
 		// If the nodes are in different groups, add the edge
 		if(labels[from] != labels[to])
@@ -71,6 +417,94 @@ vector<Edge> compute_next_edges(const vector<Edge>& edges, const vector<uint32_t
 			nextEdges.push_back(edge);
 		}
 	}
+}
+
+uint32_t calculate_chunk_size(uint32_t nNodes, int chunks)
+{
+	// Round up, so that chunks * chunk_size >= nNodes
+	return max<uint32_t>(1, ((uint64_t)nNodes + chunks - 1) / chunks);
+}
+
+vector<uint32_t> bucket_edges_by_chunk(vector<Edge>& edges, uint32_t chunk_size, int chunks, bool by_last_endpoint)
+{
+	// Count the edges of every bucket
+	vector<uint32_t> buckets(chunks + 1, 0);
+	for(const Edge& edge : edges)
+		buckets[(by_last_endpoint ? max(edge.from, edge.to) : edge.from) / chunk_size + 1]++;
+
+	// Offsets of the buckets
+	partial_sum(buckets.begin(), buckets.end(), buckets.begin());
+
+	// Place every edge in its bucket
+	vector<Edge> sorted_edges(edges.size());
+	vector<uint32_t> next_position(buckets.begin(), buckets.end() - 1);
+	for(const Edge& edge : edges)
+		sorted_edges[next_position[(by_last_endpoint ? max(edge.from, edge.to) : edge.from) / chunk_size]++] = edge;
+
+	edges.swap(sorted_edges);
+
+	return buckets;
+}
+
+void pipelined_hook_and_reduce(int rank, uint32_t nNodes, const vector<Edge>& edges, const vector<uint32_t>& buckets, uint32_t chunk_size, uint32_t* labels, PhaseWaitTimes& times)
+{
+	int chunks = buckets.size() - 1;
+	vector<MPI_Request> requests(chunks, MPI_REQUEST_NULL);
+
+	for(int k = 0; k < chunks; k++)
+	{
+		// Hook the edges with from in chunk k: they only write the labels of chunk k
+		for(uint32_t i = buckets[k]; i < buckets[k + 1]; i++)
+		{
+			uint32_t from = edges[i].from;
+			uint32_t to = edges[i].to;
+
+			if(labels[from] < to)
+				labels[from] = to;
+		}
+
+		// Start the reduction of chunk k, it runs while the next chunk is hooked
+		uint32_t first = min<uint64_t>((uint64_t)k * chunk_size, nNodes);
+		uint32_t count = min<uint64_t>((uint64_t)(k + 1) * chunk_size, nNodes) - first;
+		MPI_Ireduce(rank == 0 ? MPI_IN_PLACE : labels + first, labels + first, count, MPI_UINT32_T, MPI_MAX, 0, MPI_COMM_WORLD, &requests[k]);
+
+		// Let MPI progress the reduction of the previous chunk
+		if(k > 0)
+		{
+			int done;
+			MPI_Test(&requests[k - 1], &done, MPI_STATUS_IGNORE);
+		}
+	}
+
+	double start = MPI_Wtime();
+	MPI_Waitall(chunks, requests.data(), MPI_STATUSES_IGNORE);
+	times.reduce += MPI_Wtime() - start;
+}
+
+vector<Edge> pipelined_bcast_and_next_edges(uint32_t nNodes, const vector<Edge>& edges, const vector<uint32_t>& buckets, uint32_t chunk_size, uint32_t* labels, PhaseWaitTimes& times)
+{
+	int chunks = buckets.size() - 1;
+	vector<MPI_Request> requests(chunks, MPI_REQUEST_NULL);
+
+	// Start the broadcast of every chunk
+	for(int k = 0; k < chunks; k++)
+	{
+		uint32_t first = min<uint64_t>((uint64_t)k * chunk_size, nNodes);
+		uint32_t count = min<uint64_t>((uint64_t)(k + 1) * chunk_size, nNodes) - first;
+		MPI_Ibcast(labels + first, count, MPI_UINT32_T, 0, MPI_COMM_WORLD, &requests[k]);
+	}
+
+	vector<Edge> nextEdges;
+
+	// The edges of bucket k only need the labels of chunks 0..k: compute them while the next chunks arrive
+	for(int k = 0; k < chunks; k++)
+	{
+		double start = MPI_Wtime();
+		MPI_Wait(&requests[k], MPI_STATUS_IGNORE);
+		times.bcast += MPI_Wtime() - start;
+
+		append_next_edges(edges.data() + buckets[k], edges.data() + buckets[k + 1], labels, nextEdges);
+	}
 
 	return nextEdges;
 }
\ No newline at end of file
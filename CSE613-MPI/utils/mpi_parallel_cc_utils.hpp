@@ -7,17 +7,98 @@
 #include <cstdlib>
 #include <cassert>
 #include <utility>
+#include <string>
 //Custom libraries
 #include "Edge.hpp"
 #include "MPIEdge.hpp"
 
+// Command line options of the MPI connected components
+struct CCOptions
+{
+	string input_file;
+	// Share one copy of the labels between the processes of the same node
+	bool shared_labels = false;
+	// Number of chunks of the pipelined round (0: blocking collectives)
+	int pipeline_chunks = 0;
+	// Below this number of remaining edges the master finishes alone with the union-find (0: never)
+	uint32_t serial_cutoff = 0;
+	// Give every processor the edges of a range of source vertices instead of the edges in arrival order
+	bool source_partition = false;
+	// Log the edges and the touched vertices of every processor
+	bool partition_stats = false;
+	// Arrange the processors in a 2D grid (checkerboard decomposition of the edges)
+	bool grid = false;
+};
+
+// Square grid of processors for the 2D decomposition: the processor of row i and column j
+// owns the edges from the vertex block i to the vertex block j (block of v = v % side)
+struct ProcessGrid
+{
+	int side;				// The processors are arranged in a side x side grid
+	int row, column;		// Position of the processor in the grid
+	MPI_Comm row_comm;		// Processors of the same row (rank in the row = column)
+	MPI_Comm column_comm;	// Processors of the same column (rank in the column = row)
+};
+
+// Number of source vertex ranges per processor used to sort the edges before slicing them
+#define SOURCE_BUCKETS_PER_PROCESSOR 64
+
+// Time spent waiting in the collectives of every phase of the rounds (seconds)
+struct PhaseWaitTimes
+{
+	double scatter = 0;
+	double reduce = 0;
+	double bcast = 0;
+	double gather = 0;
+};
+
+// Function to parse the command line options: returns false if they are not valid
+bool parse_options(int argc, char* argv[], CCOptions& options);
+// Function to print the max and the average wait time of every phase over all the processes
+void report_wait_times(int rank, int group_size, const PhaseWaitTimes& times);
+
 // Function to get the number of edges to send to every processor
 vector<int> calculate_edges_per_processor(int group_size, const vector<Edge>& edges);
+// Function to sort the edges by source vertex range (counting sort), so that the equal slices cover compact label windows
+void partition_edges_by_source(int group_size, uint32_t nNodes, vector<Edge>& edges);
+// Function to log the edge count, the touched vertices and the source window of every processor
+void log_partition_stats(int rank, int group_size, const vector<Edge>& edges_slice);
+// Function to create the row and column communicators: returns false if the group size is not a square
+bool create_process_grid(int rank, int group_size, ProcessGrid& grid);
+// Function to free the row and column communicators
+void free_process_grid(ProcessGrid& grid);
+// Function to sort the edges by grid block (counting sort): returns the number of edges to send to every processor
+vector<int> partition_edges_by_grid(const ProcessGrid& grid, uint32_t nNodes, vector<Edge>& edges);
+// Function to hook the nodes and merge the labels of the vertex blocks along the rows, then on the master.
+// The labels of the processors other than the master must start at 0
+void grid_hook_and_merge(int rank, uint32_t nNodes, const ProcessGrid& grid, const vector<Edge>& edges, vector<uint32_t>& labels, PhaseWaitTimes& times);
+// Function to send the roots of the master to the processors: every processor only receives the blocks of its row and column
+void grid_bcast_roots(int rank, uint32_t nNodes, const ProcessGrid& grid, vector<uint32_t>& labels);
 // Function to get the displacements for the scatterv / gatherv functions
 vector<int> calculate_displacements(int group_size, const vector<int>& edges_per_processor);
 // Function to hook nodes
 void hook_nodes(const vector<Edge>& edges, vector<uint32_t>& labels);
+// Function to hook nodes in labels shared with the other processes of the node (atomic max)
+void hook_nodes_shared(const vector<Edge>& edges, uint32_t* labels);
+// Function to finish the connected components on the master with the union-find: the endpoints of the edges must be roots
+void finish_with_union_find(uint32_t nNodes, const vector<Edge>& edges, uint32_t* labels);
 // Function to find the roots for every node
 void find_roots(uint32_t nNodes, vector<uint32_t>& labels);
+void find_roots(uint32_t nNodes, uint32_t* labels);
 // Function to compute the next edges
-vector<Edge> compute_next_edges(const vector<Edge>& edges, const vector<uint32_t>& labels);
\ No newline at end of file
+vector<Edge> compute_next_edges(const vector<Edge>& edges, const vector<uint32_t>& labels);
+vector<Edge> compute_next_edges(const vector<Edge>& edges, const uint32_t* labels);
+// Function to append the next edges of the range [begin, end) to nextEdges
+void append_next_edges(const Edge* begin, const Edge* end, const uint32_t* labels, vector<Edge>& nextEdges);
+
+// Function to get the size of the chunks of the label array for the pipelined round
+uint32_t calculate_chunk_size(uint32_t nNodes, int chunks);
+// Function to sort the edges in one bucket per chunk of vertices (counting sort): returns the chunks + 1 offsets of the buckets.
+// The bucket is the chunk of from, or with by_last_endpoint the highest chunk of the two endpoints
+vector<uint32_t> bucket_edges_by_chunk(vector<Edge>& edges, uint32_t chunk_size, int chunks, bool by_last_endpoint);
+// Function to hook the nodes one chunk at a time, the reduction of every chunk runs while the next one is hooked.
+// The edges must be bucketed by from. The labels of the processes other than the root must start at 0
+void pipelined_hook_and_reduce(int rank, uint32_t nNodes, const vector<Edge>& edges, const vector<uint32_t>& buckets, uint32_t chunk_size, uint32_t* labels, PhaseWaitTimes& times);
+// Function to broadcast the labels one chunk at a time, the next edges of a chunk are computed as soon as it arrives.
+// The edges must be bucketed by their last endpoint
+vector<Edge> pipelined_bcast_and_next_edges(uint32_t nNodes, const vector<Edge>& edges, const vector<uint32_t>& buckets, uint32_t chunk_size, uint32_t* labels, PhaseWaitTimes& times);
\ No newline at end of file
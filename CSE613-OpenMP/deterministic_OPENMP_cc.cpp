@@ -16,8 +16,6 @@
 
 using namespace std;
 
-vector<uint32_t>& par_deterministic_cc(uint32_t nNodes, const vector<Edge>& edges, vector<uint32_t>& labels, int* iteration);
-
 int main(int argc, char* argv[]) {	
 
 	//---------------------- Read the graph ----------------------
@@ -67,7 +65,7 @@ int main(int argc, char* argv[]) {
 	auto start = chrono::high_resolution_clock::now();
 
 	//Compute the connected components
-	vector<uint32_t>& map = par_deterministic_cc(input.vertexCount(), edges, labels, &iteration);
+	uint32_t* map = cc::par_deterministic_cc(input.vertexCount(), edges, labels.data(), &iteration);
 
 	//Stop the timer
 	auto end = chrono::high_resolution_clock::now();
@@ -85,7 +83,7 @@ int main(int argc, char* argv[]) {
 	#endif
 
 	//Count the number of connected components
-	uint32_t number_of_cc = unordered_set<uint32_t>(map.begin(), map.end()).size();
+	uint32_t number_of_cc = unordered_set<uint32_t>(map, map + input.vertexCount()).size();
 
 	// Print the results
 	cout << fixed;
@@ -101,32 +99,3 @@ int main(int argc, char* argv[]) {
 
     return 0;
 }
-
-vector<uint32_t>& par_deterministic_cc(uint32_t nNodes, const vector<Edge>& edges, vector<uint32_t>& labels, int* iteration) {
-
-	// Increment the iteration
-	(*iteration)++;
-
-	cout << "Iteration " << *iteration << " Number of edges: " << edges.size() << endl;
-
-	// Base case
-	if(edges.size() == 0 || nNodes == 0) 
-		return labels;
-
-	#pragma omp parallel for shared(nNodes, edges, labels)
-	for(uint32_t i = 0; i < edges.size(); i++)
-	{
-		uint32_t from = edges[i].from;
-		uint32_t to = edges[i].to;
-
-		//if(labels[from] < to)
-		labels[from] = to;
-	}
-
-	// Find the roots for every node
-	find_roots(nNodes, labels);
-
-	// Compute the new set of edges
-	// Recursively call the function
-	return par_deterministic_cc(nNodes, find_rank_and_remove_edges(nNodes, edges, labels), labels, iteration);
-}
\ No newline at end of file
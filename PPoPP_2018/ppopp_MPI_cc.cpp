@@ -4,6 +4,8 @@
 #include <iostream>
 #include <vector>
 #include <cstdint>
+#include <string>
+#include <cstdlib>
 
 using namespace std;
 
@@ -21,9 +23,81 @@ int32_t seed = 17;
 
 int main(int argc, char *argv[])
 {
-	if (argc != 2)
+	// Parse the options
+	bool shared_map = false;
+	bool tree_contraction = false;
+	bool compress_map = false;
+	bool dedup_edges = false;
+	float rebalance_threshold = 0;
+	uint64_t finish_cutoff_bytes = 0;
+	float epsilon = 0.09f, delta = 0.2f;
+	bool auto_epsilon = false;
+	int32_t target_size = 1;
+	bool valid_options = argc >= 2;
+	for (int i = 2; i < argc && valid_options; i++)
 	{
-		cout << "Usage: connectivity INPUT_FILE" << endl;
+		string option = argv[i];
+		if (option == "--shared-map")
+			shared_map = true;
+		else if (option == "--tree-contraction")
+			tree_contraction = true;
+		else if (option == "--compress-map")
+			compress_map = true;
+		else if (option == "--dedup-edges")
+			dedup_edges = true;
+		else if (option.compare(0, 15, "--finish-below=") == 0)
+		{
+			double megabytes = atof(option.c_str() + 15);
+			if (megabytes <= 0)
+			{
+				cout << "Invalid memory bound: " << option << endl;
+				valid_options = false;
+			}
+			finish_cutoff_bytes = uint64_t(megabytes * 1024 * 1024);
+		}
+		else if (option == "--epsilon=auto")
+			auto_epsilon = true;
+		else if (option.compare(0, 10, "--epsilon=") == 0)
+			epsilon = atof(option.c_str() + 10);
+		else if (option.compare(0, 8, "--delta=") == 0)
+			delta = atof(option.c_str() + 8);
+		else if (option.compare(0, 14, "--target-size=") == 0)
+			target_size = atoi(option.c_str() + 14);
+		else if (option.compare(0, 7, "--seed=") == 0)
+			seed = atoi(option.c_str() + 7);
+		else if (option.compare(0, 12, "--rebalance=") == 0)
+		{
+			// max/avg is never below 1
+			rebalance_threshold = atof(option.c_str() + 12);
+			if (rebalance_threshold < 1)
+			{
+				cout << "Invalid rebalance threshold: " << option << endl;
+				valid_options = false;
+			}
+		}
+		else
+		{
+			cout << "Unknown option: " << option << endl;
+			valid_options = false;
+		}
+	}
+
+	if (epsilon <= 0 || delta <= 0 || target_size < 1)
+	{
+		cout << "Epsilon and delta must be positive, the target size at least 1" << endl;
+		valid_options = false;
+	}
+
+	// The shared map is broadcast between the node leaders by NodeSharedArray, without encoding
+	if (shared_map && compress_map)
+	{
+		cout << "--compress-map cannot be used with --shared-map" << endl;
+		valid_options = false;
+	}
+
+	if (!valid_options)
+	{
+		cout << "Usage: connectivity INPUT_FILE [--shared-map] [--tree-contraction] [--compress-map] [--dedup-edges] [--rebalance=MAX_OVER_AVG] [--finish-below=MEGABYTES] [--epsilon=X|auto] [--delta=X] [--target-size=N] [--seed=N]" << endl;
 		return 1;
 	}
 
@@ -39,11 +113,27 @@ int main(int argc, char *argv[])
 	GraphInputIterator input(argv[1]);
 
 	// Create a sampler object in which the graph will be loaded
-	SparseSampling sampler(MPI_COMM_WORLD, group_size, rank, seed + rank, (int32_t)1, input.vertexCount(), input.edgeCount());
+	SparseSampling sampler(MPI_COMM_WORLD, group_size, rank, seed + rank, target_size, input.vertexCount(), input.edgeCount());
+
+	sampler.epsilon_ = epsilon;
+	sampler.delta_ = delta;
+	if (auto_epsilon)
+		sampler.autoTuneEpsilon();
 
 	// Load the appropriate slice of the graph in every process
 	sampler.loadSlice(input);
 
+	// Share one copy of the vertex map between the processes of the same node
+	if (shared_map)
+		sampler.enableSharedMapping();
+
+	// Contract the samples on a binomial tree instead of gathering them on the root
+	sampler.tree_contraction_ = tree_contraction;
+	sampler.compress_map_ = compress_map;
+	sampler.dedup_edges_ = dedup_edges;
+	sampler.rebalance_threshold_ = rebalance_threshold;
+	sampler.finish_cutoff_bytes_ = finish_cutoff_bytes;
+
 	// Wait for all processes to finish loading the graph
 	//Blocks the caller until all processes in the communicator have called it
 	MPI_Barrier(MPI_COMM_WORLD);
@@ -54,22 +144,36 @@ int main(int argc, char *argv[])
 	// Compute the connected components
 	vector<uint32_t> components;
 	int number_of_components = sampler.connectedComponents(components);
+	double end_time = MPI_Wtime();
+
+	// Total number of parallel edges removed by the processes
+	unsigned long long duplicate_edges = 0, local_duplicate_edges = sampler.duplicate_edges_;
+	if (dedup_edges)
+		MPI_Reduce(&local_duplicate_edges, &duplicate_edges, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
 
 	// Output the number of connected components if the process is the master
 	if (rank == 0)
 	{
-		double end_time = MPI_Wtime();
 		double elapsed_time = end_time - start_time;
 
 		cout << fixed;
 		cout << "File Name: " << argv[1] << endl;
 		cout << "Group Size: " << group_size << endl;
+		cout << "Epsilon: " << sampler.epsilon_ << " Delta: " << sampler.delta_ << endl;
 		cout << "Number of vertices: " << input.vertexCount() << endl;
 		cout << "Number of edges: " << input.edgeCount() << endl;
+		cout << "Iterations: " << sampler.rounds_ << endl;
+		if (finish_cutoff_bytes > 0)
+			cout << "Rounds saved (at most): " << sampler.rounds_saved_ << endl;
+		if (dedup_edges)
+			cout << "Duplicate edges removed: " << duplicate_edges << endl;
 		cout << "Number of connected components: " << number_of_components << endl;
 		cout << "Elapsed time: " << elapsed_time << " seconds" << endl;
 	}
 
+	// Free the shared window before closing MPI
+	sampler.releaseSharedMapping();
+
 	// Close MPI
 	MPI_Finalize();
 }
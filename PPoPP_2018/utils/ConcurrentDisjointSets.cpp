@@ -0,0 +1 @@
+#include "ConcurrentDisjointSets.hpp"
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+//OpenMP header
+#include <omp.h>
+//Standard libraries
+#include <vector>
+#include <iostream>
+#include <cstdint>
+
+using namespace std;
+
+// Lock-free union-find for the OpenMP threads: the parents are updated with compare-and-swap.
+// A root is always linked under a smaller root, so the root of every set is its smallest element
+class ConcurrentDisjointSets
+{
+	vector<uint32_t> parents; // Init to 0, 1, 2, 3, ...
+
+public:
+	ConcurrentDisjointSets(size_t element_count) : parents(element_count)
+	{
+		#pragma omp parallel for
+		for (size_t i = 0; i < element_count; i++)
+			parents[i] = i;
+	}
+
+	ConcurrentDisjointSets(const ConcurrentDisjointSets &that) = delete;
+
+	// Find with path halving: safe while other threads unify
+	uint32_t find(uint32_t elem)
+	{
+		while (true)
+		{
+			uint32_t parent = __atomic_load_n(&parents[elem], __ATOMIC_RELAXED);
+			if (parent == elem)
+				return elem;
+
+			uint32_t grandparent = __atomic_load_n(&parents[parent], __ATOMIC_RELAXED);
+			// Skip one level: if another thread changed the parent in the meantime, nothing is lost
+			if (parent != grandparent)
+				__atomic_compare_exchange_n(&parents[elem], &parent, grandparent, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+			elem = grandparent;
+		}
+	}
+
+	// Returns true if a and b were in different sets
+	bool unify(uint32_t a, uint32_t b)
+	{
+		while (true)
+		{
+			a = find(a);
+			b = find(b);
+			if (a == b)
+				return false;
+
+			// Link the bigger root under the smaller one
+			if (a < b)
+				swap(a, b);
+			uint32_t expected = a;
+			if (__atomic_compare_exchange_n(&parents[a], &expected, b, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+				return true;
+			// a is not a root anymore: retry from the new roots
+		}
+	}
+
+	size_t size() const { return parents.size(); }
+
+	// Storage of the parents, reusable once the sets are not needed anymore
+	vector<uint32_t> &data() { return parents; }
+};
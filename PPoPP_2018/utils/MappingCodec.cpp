@@ -0,0 +1 @@
+#include "MappingCodec.hpp"
\ No newline at end of file
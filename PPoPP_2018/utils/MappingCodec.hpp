@@ -0,0 +1,156 @@
+#pragma once
+
+//Standard libraries
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+// Encodings of a vertex map
+enum MappingEncoding : uint64_t
+{
+	RAW_MAPPING = 0,		// One uint32_t per vertex
+	BITPACKED_MAPPING = 1,	// ceil(log2(label_count)) bits per vertex
+	RUN_LENGTH_MAPPING = 2	// Runs of equal or consecutive labels: (first label | step << 32, length)
+};
+
+// Vertex map encoded in 64-bit words, ready to be broadcast
+struct EncodedMapping
+{
+	uint64_t encoding = RAW_MAPPING;
+	uint64_t bits = 32;
+	vector<uint64_t> words;
+
+	uint64_t bytes() const { return words.size() * sizeof(uint64_t); }
+
+	const char *name() const
+	{
+		return encoding == BITPACKED_MAPPING ? "bit-packed" : encoding == RUN_LENGTH_MAPPING ? "run-length" : "raw";
+	}
+};
+
+// Compression of the vertex map: the map only has label_count distinct values and long runs of consecutive labels
+struct MappingCodec
+{
+	// Encode the map with the smallest of the encodings. Every label must be smaller than label_count
+	static EncodedMapping encode(const vector<uint32_t> &vertex_map, uint32_t label_count)
+	{
+		uint64_t vertex_count = vertex_map.size();
+		EncodedMapping encoded;
+
+		// Bits needed to store a label in [0, label_count)
+		encoded.bits = 1;
+		while (encoded.bits < 32 && (uint64_t(1) << encoded.bits) < label_count)
+			encoded.bits++;
+
+		// Size of every encoding in 64-bit words (the bit-packed one has a padding word for the decoder)
+		uint64_t raw_words = (vertex_count + 1) / 2;
+		uint64_t packed_words = (vertex_count * encoded.bits + 63) / 64 + 1;
+		uint64_t run_words = 2 * countRuns(vertex_map);
+
+		if (run_words < packed_words && run_words < raw_words)
+		{
+			encoded.encoding = RUN_LENGTH_MAPPING;
+			encodeRuns(vertex_map, encoded.words);
+		}
+		else if (packed_words < raw_words)
+		{
+			encoded.encoding = BITPACKED_MAPPING;
+			encoded.words.assign(packed_words, 0);
+			for (uint64_t i = 0; i < vertex_count; i++)
+			{
+				uint64_t bit = i * encoded.bits;
+				encoded.words[bit >> 6] |= uint64_t(vertex_map[i]) << (bit & 63);
+				// The label continues in the next word
+				if ((bit & 63) + encoded.bits > 64)
+					encoded.words[(bit >> 6) + 1] |= uint64_t(vertex_map[i]) >> (64 - (bit & 63));
+			}
+		}
+		else
+		{
+			encoded.encoding = RAW_MAPPING;
+			encoded.words.assign(raw_words, 0);
+			memcpy(encoded.words.data(), vertex_map.data(), vertex_count * sizeof(uint32_t));
+		}
+
+		return encoded; // NRVO
+	}
+
+	// Decode the map in vertex_map, which must have vertex_count elements
+	static void decode(const EncodedMapping &encoded, uint32_t *vertex_map, uint64_t vertex_count)
+	{
+		if (encoded.encoding == RAW_MAPPING)
+		{
+			memcpy(vertex_map, encoded.words.data(), vertex_count * sizeof(uint32_t));
+		}
+		else if (encoded.encoding == BITPACKED_MAPPING)
+		{
+			const uint64_t *words = encoded.words.data();
+			const uint64_t bits = encoded.bits;
+			const uint64_t mask = (uint64_t(1) << bits) - 1;
+
+			// Branch-free: the padding word makes the read of the next word always valid, so the loop vectorizes
+			#pragma omp simd
+			for (uint64_t i = 0; i < vertex_count; i++)
+			{
+				uint64_t bit = i * bits;
+				uint64_t shift = bit & 63;
+				uint64_t low = words[bit >> 6] >> shift;
+				// Two shifts to avoid a shift by 64 when shift is 0
+				uint64_t high = (words[(bit >> 6) + 1] << 1) << (63 - shift);
+				vertex_map[i] = uint32_t((low | high) & mask);
+			}
+		}
+		else
+		{
+			uint64_t position = 0;
+			for (uint64_t run = 0; run < encoded.words.size(); run += 2)
+			{
+				uint32_t first = uint32_t(encoded.words[run]);
+				uint32_t step = uint32_t(encoded.words[run] >> 32);
+				uint64_t length = encoded.words[run + 1];
+
+				for (uint64_t k = 0; k < length; k++)
+					vertex_map[position + k] = first + uint32_t(k) * step;
+				position += length;
+			}
+		}
+	}
+
+private:
+	// Length of the run starting at position start, with its step (0: equal labels, 1: consecutive labels)
+	static uint64_t runLength(const vector<uint32_t> &vertex_map, uint64_t start, uint32_t &step)
+	{
+		step = (start + 1 < vertex_map.size() && vertex_map[start + 1] == vertex_map[start] + 1) ? 1 : 0;
+
+		uint64_t end = start + 1;
+		while (end < vertex_map.size() && vertex_map[end] == vertex_map[end - 1] + step)
+			end++;
+
+		return end - start;
+	}
+
+	static uint64_t countRuns(const vector<uint32_t> &vertex_map)
+	{
+		uint64_t runs = 0;
+		uint32_t step;
+		for (uint64_t i = 0; i < vertex_map.size(); i += runLength(vertex_map, i, step))
+			runs++;
+		return runs;
+	}
+
+	static void encodeRuns(const vector<uint32_t> &vertex_map, vector<uint64_t> &words)
+	{
+		uint32_t step;
+		for (uint64_t i = 0; i < vertex_map.size();)
+		{
+			uint64_t length = runLength(vertex_map, i, step);
+			words.push_back(uint64_t(vertex_map[i]) | (uint64_t(step) << 32));
+			words.push_back(length);
+			i += length;
+		}
+	}
+};
@@ -6,6 +6,10 @@
 #include "MPIEdge.hpp"
 #include "GraphInputIterator.hpp"
 #include "DisjointSets.hpp"
+#include "ConcurrentDisjointSets.hpp"
+#include "NodeSharedArray.hpp"
+#include "MappingCodec.hpp"
+#include "../../CC-Library/cc/Instrumentation.hpp"
 // Standard libraries
 #include <iostream>
 #include <vector>
@@ -14,6 +18,9 @@
 #include <cmath>
 #include <cstdint>
 #include <random>
+#include <memory>
+#include <string>
+#include <unistd.h>
 
 using namespace std;
 
@@ -28,14 +35,23 @@ public:
 
 	// Graph related variables
 	uint32_t target_size_, vertex_count_, initial_vertex_count_, initial_edge_count_;
+	uint32_t rounds_;		   // Number of sampling rounds done by connectedComponents
 	vector<Edge> edges_slice_; // Slice of the graph edges: block of edges distributed to each process
+	unique_ptr<NodeSharedArray> shared_map_; // Vertex map shared by the processes of the same node (optional)
+	bool tree_contraction_;	   // Contract the samples on a binomial tree instead of gathering them on the root
+	bool compress_map_;		   // Broadcast the vertex map encoded with MappingCodec
+	bool dedup_edges_;		   // Remove the parallel edges of the slice after every contraction
+	uint64_t duplicate_edges_; // Number of parallel edges removed from the slice
+	float rebalance_threshold_; // Redistribute the edges when max/avg of the slice sizes exceeds it (0: never)
+	uint64_t finish_cutoff_bytes_; // Gather the remaining edges on the root when they fit in this many bytes (0: never)
+	uint32_t rounds_saved_;	   // Upper bound of the sampling rounds replaced by the final gather
 
 	// Other variables
-	const float epsilon_ = 0.09f;
-	const float delta_ = 0.2f;
+	float epsilon_;			   // Sample size exponent: n^(1 + epsilon / 2) edges per round
+	float delta_;			   // Oversampling factor of the sample
 	
 	// Constructor
-	SparseSampling(MPI_Comm communicator, int32_t group_size, int32_t rank, int32_t seed, int32_t target_size, uint32_t vertex_count, uint32_t edge_count) : communicator_(communicator), group_size_(group_size), rank_(rank), random_engine_(seed), target_size_(target_size), vertex_count_(vertex_count), initial_vertex_count_(vertex_count), initial_edge_count_(edge_count)
+	SparseSampling(MPI_Comm communicator, int32_t group_size, int32_t rank, int32_t seed, int32_t target_size, uint32_t vertex_count, uint32_t edge_count) : communicator_(communicator), group_size_(group_size), rank_(rank), random_engine_(seed), target_size_(target_size), vertex_count_(vertex_count), initial_vertex_count_(vertex_count), initial_edge_count_(edge_count), rounds_(0), tree_contraction_(false), compress_map_(false), dedup_edges_(false), duplicate_edges_(0), rebalance_threshold_(0), finish_cutoff_bytes_(0), rounds_saved_(0), epsilon_(0.09f), delta_(0.2f)
 	{
 		// Construct the MPI edge type
 		mpi_edge_t_ = MPIEdge::constructType();
@@ -49,63 +65,249 @@ public:
 		return rank_ == 0;
 	}
 
-	// The root will receive the labels of the connected components in the vector
-	uint32_t connectedComponents(vector<uint32_t> &connected_components)
+	// Keep one copy of the vertex map per node instead of one per process. Collective call
+	void enableSharedMapping()
+	{
+		shared_map_.reset(new NodeSharedArray(communicator_, initial_vertex_count_));
+	}
+
+	// The tree contraction ignores the order of the samples: it is only possible without an intermediate target size
+	bool treeContraction() const
+	{
+		return tree_contraction_ && target_size_ <= 1;
+	}
+
+	// Free the shared window: must be called before MPI_Finalize. Collective call
+	void releaseSharedMapping()
+	{
+		shared_map_.reset();
+	}
+
+	/**
+	 * Choose epsilon from the measured cost of the collectives and the memory available on the root. Collective call.
+	 * A round costs about six small collectives plus the gather and the contraction of its sample, and about 1 / epsilon rounds are needed
+	 * (a single one when the sample holds all the edges): take the epsilon with the smallest estimated total cost
+	 * among the ones whose sample fits in a quarter of the free memory of the root.
+	 */
+	void autoTuneEpsilon()
 	{
+		const int32_t repetitions = 10;
+
+		// Latency of the small collectives of a round
+		uint32_t value = 1, sum;
+		MPI_Barrier(communicator_);
+		double start = MPI_Wtime();
+		for (int32_t i = 0; i < repetitions; i++)
+			MPI_Allreduce(&value, &sum, 1, MPI_UINT32_T, MPI_SUM, communicator_);
+		double round_latency = 6 * (MPI_Wtime() - start) / repetitions;
+
+		// Time to gather and contract one edge on the root: a probe of about 1 MB of random edges
+		const uint32_t probe_edges = max((1u << 17) / group_size_, 1u), probe_vertices = probe_edges * group_size_;
+		vector<Edge> probe(probe_edges), gathered(master() ? probe_vertices : 0);
+		for (Edge &edge : probe)
+			edge = Edge{boundedRandom(probe_vertices), boundedRandom(probe_vertices)};
+		MPI_Barrier(communicator_);
+		start = MPI_Wtime();
+		MPI_Gather(probe.data(), probe_edges, mpi_edge_t_, gathered.data(), probe_edges, mpi_edge_t_, 0, communicator_);
 		if (master())
 		{
-			// Reset the connected components vector to the size of the vertex count
-			connected_components.resize(vertex_count_);
+			vector<uint32_t> probe_map(probe_vertices);
+			uint32_t probe_components;
+			parallelConnectedComponents(gathered, probe_map, probe_components);
+		}
+		double edge_time = (MPI_Wtime() - start) / probe_vertices;
+
+		if (master())
+		{
+			// Free memory of the root: the samples share it with the vertex map, the labels and the union-find
+			double budget = double(sysconf(_SC_AVPHYS_PAGES)) * sysconf(_SC_PAGESIZE) / 4 - 3.0 * sizeof(uint32_t) * initial_vertex_count_;
+
+			float best_epsilon = 0.01f;
+			double best_cost = -1;
+			for (float epsilon = 0.01f; epsilon <= 1.0f; epsilon += 0.01f)
+			{
+				double sample_edges = pow(double(initial_vertex_count_), 1 + epsilon / 2) * (1 + delta_);
+				if (sample_edges * sizeof(Edge) > budget && best_cost >= 0)
+					break;
+
+				double rounds = min(ceil(1.0 / epsilon), max(ceil(initial_edge_count_ / sample_edges), 1.0));
+				double cost = rounds * (round_latency + min(sample_edges, double(initial_edge_count_)) * edge_time);
+				if (best_cost < 0 || cost < best_cost)
+				{
+					best_cost = cost;
+					best_epsilon = epsilon;
+				}
+			}
+			epsilon_ = best_epsilon;
 
-			// Initialize the connected components vector
-			for (uint32_t i = 0; i < vertex_count_; i++)
-				connected_components.at(i) = i;
+			string str = "Auto-tuned epsilon: " + to_string(epsilon_) + " Round latency: " + to_string(round_latency) + " seconds Edge gather and contraction time: " + to_string(edge_time * 1e9) + " ns Root memory budget: " + to_string(uint64_t(max(budget, 0.0)) >> 20) + " MB\n";
+			cout << str;
 		}
 
-		// We could use just one edge info exchange per round
+		MPI_Bcast(&epsilon_, 1, MPI_FLOAT, 0, communicator_);
+	}
+
+	// The root will receive the labels of the connected components in the vector
+	uint32_t connectedComponents(vector<uint32_t> &connected_components)
+	{
+		// Vertex maps of the rounds, kept by the root and composed once at the end: the work of a round
+		// then depends on the current vertex count only, not on the initial one
+		vector<vector<uint32_t>> round_maps;
 
 		// While there are edges to process in the whole graph
-		while (countEdges() > 0) // Count the number of edges in the whole graph
+		while (true)
 		{
-			// Initialize the vertex map with vertex_count_ elements
-			vector<uint32_t> vertex_map(vertex_count_); 
+			CC_ROUND(0, vertex_count_);
+
+			// One collective per round: every processor gets the size of every slice, so it can check the termination
+			// and compute the sampling plan by itself
+			CC_PHASE_START(GATHER);
+			vector<int32_t> edges_per_processor = edgesAvailablePerProcessor();
+			CC_PHASE_STOP(GATHER);
+			uint32_t remaining_edges = accumulate(edges_per_processor.begin(), edges_per_processor.end(), 0u);
+			CC_ROUND_EDGES(remaining_edges);
+			if (remaining_edges == 0)
+				break;
+
+			// Few edges left: one gather instead of the collectives of the remaining rounds
+			if (uint64_t(remaining_edges) * sizeof(Edge) <= finish_cutoff_bytes_)
+			{
+				gatherAndFinish(round_maps, edges_per_processor);
+				break;
+			}
 
-			// NOTE:
-			//  edgesAvailablePerProcessor() returns the number of edges available to each node: only the master node will have the vector edges_per_processor
+			rounds_++;
 
-			if (master())
+			// Size of the vertex map: the number of vertices before the contraction
+			const uint32_t map_size = vertex_count_;
+			// Initialize the vertex map with map_size elements (only the root needs it when the map is shared by the node)
+			vector<uint32_t> vertex_map(master() || !shared_map_ ? map_size : 0);
+
+			if (rebalance_threshold_ > 0)
 			{
-				initiateSampling(edgesToSamplePerProcessor(edgesAvailablePerProcessor()), vertex_map);
+				CC_PHASE(SCATTER);
+				rebalanceEdges(edges_per_processor);
+			}
 
-				for (uint32_t i = 0; i < connected_components.size(); i++)
-					connected_components.at(i) = vertex_map.at(connected_components.at(i));
+			// Same plan on every processor: no need to scatter it
+			vector<int32_t> edges_to_sample = edgesToSamplePerProcessor(edges_per_processor);
+
+			if (master())
+			{
+				initiateSampling(edges_to_sample, vertex_map);
 			}
 			else
 			{
-				edgesAvailablePerProcessor();
-				acceptSamplingRequest();
+				acceptSamplingRequest(edges_to_sample.at(rank_));
 			}
 
-			receiveAndApplyMapping(vertex_map);
+			receiveAndApplyMapping(vertex_map, map_size);
+
+			if (master())
+				round_maps.push_back(move(vertex_map));
 		}
 
+		if (master())
+			composeRoundMaps(round_maps, connected_components);
+
 		return vertex_count_;
 	}
 
+	/**
+	 * Compose the maps of the rounds, from the last one to the first one: the cost is the sum of the map sizes
+	 * @param [in] round_maps the maps of the rounds, freed while they are composed
+	 * @param [out] connected_components the label of every initial vertex
+	 */
+	void composeRoundMaps(vector<vector<uint32_t>> &round_maps, vector<uint32_t> &connected_components)
+	{
+		// Without contraction every vertex is its own component
+		if (round_maps.empty())
+		{
+			connected_components.resize(initial_vertex_count_);
+			iota(connected_components.begin(), connected_components.end(), 0u);
+			return;
+		}
+
+		vector<uint32_t> composed;
+		composed.swap(round_maps.back());
+		round_maps.pop_back();
+		while (!round_maps.empty())
+		{
+			// composed becomes composed(round_map(v)) for the vertices of the previous round
+			vector<uint32_t> &round_map = round_maps.back();
+			#pragma omp parallel for
+			for (size_t i = 0; i < round_map.size(); i++)
+				round_map[i] = composed[round_map[i]];
+			composed.swap(round_map);
+			round_maps.pop_back();
+		}
+
+		connected_components.swap(composed);
+	}
+
+	/**
+	 * Gather all the remaining edges on the root and contract them at once with the threads of the root
+	 * @param [in,out] round_maps the maps of the rounds of the root, the map of the final contraction is added
+	 * @param edges_per_processor the size of the slice of every processor
+	 */
+	void gatherAndFinish(vector<vector<uint32_t>> &round_maps, const vector<int32_t> &edges_per_processor)
+	{
+		uint32_t remaining_edges = accumulate(edges_per_processor.begin(), edges_per_processor.end(), 0u);
+		vector<int32_t> displacements(group_size_, 0);
+		for (int32_t i = 1; i < group_size_; i++)
+			displacements[i] = displacements[i - 1] + edges_per_processor[i - 1];
+
+		vector<Edge> remaining(master() ? remaining_edges : 0);
+		CC_PHASE_START(GATHER);
+		MPI_Gatherv(edges_slice_.data(), edges_slice_.size(), mpi_edge_t_, remaining.data(), edges_per_processor.data(), displacements.data(), mpi_edge_t_, 0, communicator_);
+		CC_PHASE_STOP(GATHER);
+		CC_PHASE_BYTES(GATHER, edges_slice_.size() * sizeof(Edge));
+		vector<Edge>().swap(edges_slice_);
+
+		if (master())
+		{
+			CC_PHASE(CONTRACT);
+			double root_start = MPI_Wtime();
+			vector<uint32_t> vertex_map(vertex_count_);
+			uint32_t resulting_vertex_count = 0;
+			parallelConnectedComponents(remaining, vertex_map, resulting_vertex_count);
+			round_maps.push_back(move(vertex_map));
+			double root_time = MPI_Wtime() - root_start;
+
+			// The sampling would need at least one round, and at most one round per sample of the remaining edges
+			uint64_t edges_per_round = uint64_t(pow((float)initial_vertex_count_, 1 + epsilon_ / 2) * (1 + delta_));
+			rounds_saved_ = (remaining_edges + edges_per_round - 1) / edges_per_round;
+
+			string str = "Gather and finish: " + to_string(remaining_edges) + " edges gathered Vertices: " + to_string(vertex_count_) + " -> " + to_string(resulting_vertex_count) + " Root time: " + to_string(root_time) + " seconds\n";
+			cout << str;
+
+			vertex_count_ = resulting_vertex_count;
+		}
+
+		MPI_Bcast(&vertex_count_, 1, MPI_UINT32_T, 0, communicator_);
+	}
+
 	// Load a slice of the graph edges: useful for parallel processing
 	void loadSlice(GraphInputIterator &input)
 	{
 		input.loadSlice(edges_slice_, rank_, group_size_);
 	}
 
-	// Count the number of edges in the whole graph
-	uint32_t countEdges()
+	// Receive the slice of the edges held by the root, with the same blocks as loadSlice. Collective call:
+	// edges is only read on the root and must have the edge count given to the constructor
+	void scatterSlice(const vector<Edge> &edges)
 	{
-		uint32_t local_edges = edges_slice_.size(), edges;
-		// MPI_Allreduce combines values from all processes and distributes the result back to all processes 
-		MPI_Allreduce(&local_edges, &edges, 1, MPI_UINT32_T, MPI_SUM, communicator_);
-		// Returns the total number of edges in the graph
-		return edges;
+		uint32_t slice_portion = initial_edge_count_ / group_size_;
+		vector<int32_t> edges_per_processor(group_size_), displacements(group_size_);
+		for (int32_t i = 0; i < group_size_; i++)
+		{
+			// The last node takes any leftover edges
+			displacements[i] = slice_portion * i;
+			edges_per_processor[i] = (i == group_size_ - 1 ? initial_edge_count_ : slice_portion * (i + 1)) - displacements[i];
+		}
+
+		edges_slice_.resize(edges_per_processor[rank_]);
+		MPI_Scatterv(edges.data(), edges_per_processor.data(), displacements.data(), mpi_edge_t_, edges_slice_.data(), edges_per_processor[rank_], mpi_edge_t_, 0, communicator_);
 	}
 
 	// Return a vector of the number of edges that every processor should have after sampling
@@ -165,101 +367,190 @@ public:
 		return edges_per_processor;
 	}
 
-	// Returns the number of edges available to each processor (only the master processor will have the vector edges_per_processor)
+	// Returns the number of edges available to each processor (every processor gets the whole vector)
 	vector<int32_t> edgesAvailablePerProcessor()
 	{
 		// The size of the slice of the graph that each processor has
 		uint32_t available = (uint32_t)edges_slice_.size();
 
-		// Only the master processor will have the vector edges_per_processor
-		vector<int32_t> edges_per_processor;
+		// MPI_Allgather gets data from all processes to all the processes
+		vector<int32_t> edges_per_processor(group_size_);
+		MPI_Allgather(&available, 1, MPI_UINT32_T, edges_per_processor.data(), 1, MPI_UINT32_T, communicator_);
+
+		return edges_per_processor; // NRVO: Named Return Value Optimization (Compiler optimization)
+	}
+
+	/**
+	 * Redistribute the edges with MPI_Alltoallv when the slices are too uneven: the contractions empty some slices faster than the others.
+	 * Every processor computes the same plan from the sizes of all the slices: the edges keep their global order
+	 * (slice of rank 0, then slice of rank 1, ...) and are split again into equal contiguous blocks.
+	 * @param [in,out] edges_per_processor the size of the slice of every processor, updated after the redistribution
+	 * @return true if the edges were redistributed
+	 */
+	bool rebalanceEdges(vector<int32_t> &edges_per_processor)
+	{
+		uint64_t total_edges = accumulate(edges_per_processor.begin(), edges_per_processor.end(), uint64_t(0));
+		int32_t max_edges = *max_element(edges_per_processor.begin(), edges_per_processor.end());
+		double imbalance = total_edges == 0 ? 1 : double(max_edges) * group_size_ / total_edges;
+		if (imbalance <= rebalance_threshold_)
+			return false;
+
+		// Global position of the first edge of every slice, before and after the redistribution
+		vector<uint64_t> old_offsets(group_size_ + 1, 0), new_offsets(group_size_ + 1, 0);
+		for (int32_t i = 0; i < group_size_; i++)
+		{
+			old_offsets[i + 1] = old_offsets[i] + edges_per_processor[i];
+			new_offsets[i + 1] = total_edges * (i + 1) / group_size_;
+		}
+
+		// The edges exchanged by two processors are the intersection of the old slice of the sender and the new slice of the receiver
+		vector<int32_t> send_counts(group_size_), send_displacements(group_size_), receive_counts(group_size_), receive_displacements(group_size_);
+		for (int32_t i = 0; i < group_size_; i++)
+		{
+			uint64_t send_first = max(old_offsets[rank_], new_offsets[i]), send_last = min(old_offsets[rank_ + 1], new_offsets[i + 1]);
+			send_counts[i] = send_last > send_first ? int32_t(send_last - send_first) : 0;
+			send_displacements[i] = send_counts[i] > 0 ? int32_t(send_first - old_offsets[rank_]) : 0;
+
+			uint64_t receive_first = max(old_offsets[i], new_offsets[rank_]), receive_last = min(old_offsets[i + 1], new_offsets[rank_ + 1]);
+			receive_counts[i] = receive_last > receive_first ? int32_t(receive_last - receive_first) : 0;
+			receive_displacements[i] = receive_counts[i] > 0 ? int32_t(receive_first - new_offsets[rank_]) : 0;
+		}
+
+		vector<Edge> rebalanced_slice(new_offsets[rank_ + 1] - new_offsets[rank_]);
+		// MPI_Alltoallv sends a different block of data from every process to every other process
+		MPI_Alltoallv(edges_slice_.data(), send_counts.data(), send_displacements.data(), mpi_edge_t_,
+					  rebalanced_slice.data(), receive_counts.data(), receive_displacements.data(), mpi_edge_t_, communicator_);
+		edges_slice_.swap(rebalanced_slice);
+
+		for (int32_t i = 0; i < group_size_; i++)
+			edges_per_processor[i] = int32_t(new_offsets[i + 1] - new_offsets[i]);
+
 		if (master())
-			edges_per_processor.resize(group_size_);
+		{
+			string str = "Round - " + to_string(rounds_) + " Rebalanced edges: max/avg " + to_string(imbalance) + " -> " + to_string(double(*max_element(edges_per_processor.begin(), edges_per_processor.end())) * group_size_ / total_edges) + "\n";
+			cout << str;
+		}
 
-		// MPI_Gather gets data from all processes to the root process
-		MPI_Gather(&available, 1, MPI_UINT32_T, edges_per_processor.data(), 1, MPI_UINT32_T, 0, communicator_);
+		return true;
+	}
 
-		return edges_per_processor; // NRVO: Named Return Value Optimization (Compiler optimization)
+	// Uniform random number in [0, range) with Lemire's multiply-shift method: no modulo bias and almost never a division
+	uint32_t boundedRandom(uint32_t range)
+	{
+		uint64_t product = uint64_t(uint32_t(random_engine_())) * range;
+		uint32_t low = uint32_t(product);
+		if (low < range)
+		{
+			// Reject the few values that would make the result biased
+			uint32_t threshold = uint32_t(-range) % range;
+			while (low < threshold)
+			{
+				product = uint64_t(uint32_t(random_engine_())) * range;
+				low = uint32_t(product);
+			}
+		}
+		return uint32_t(product >> 32);
 	}
 
+	// Sample edge_count distinct edges of the slice (without replacement): no sampled edge is wasted on a duplicate
 	vector<Edge> sample(uint32_t edge_count)
 	{
-		vector<Edge> edges;
 		uint32_t size = edges_slice_.size();
 
 		// If the number of edges to sample is equal to the number of edges that the processor has, return the whole slice
-		if (edge_count == edges_slice_.size())
+		if (edge_count >= size)
 		{
 			return edges_slice_;
 		}
-		else
+
+		// Partial Fisher-Yates shuffle: the first edge_count edges of the slice become a uniform sample.
+		// The order of the slice does not matter, so it is shuffled in place
+		for (uint32_t i = 0; i < edge_count; i++)
 		{
-			// Randomly sample edge_count edges from the slice
-			// BUT 
-			for (uint32_t i = 0; i < edge_count; i++)
-			{
-				edges.push_back(edges_slice_.at(random_engine_() % size));
-			}
+			swap(edges_slice_[i], edges_slice_[i + boundedRandom(size - i)]);
 		}
 
-		return edges; // NRVO
+		return vector<Edge>(edges_slice_.begin(), edges_slice_.begin() + edge_count); // NRVO
 	}
 
 	uint32_t initiateSampling(vector<int32_t> edges_per_processor, vector<uint32_t> &vertex_map)
 	{
 		uint32_t number_of_edges_to_sample = accumulate(edges_per_processor.begin(), edges_per_processor.end(), 0u);
 
-		//Count of edges to sample for each processor
-		uint32_t edges_to_sample_locally;
-		//MPI_Scatter sends data from one process to all other processes in a communicator 
-		MPI_Scatter(edges_per_processor.data(), 1, MPI_INT, &edges_to_sample_locally, 1, MPI_INT, 0, communicator_);
+		//Count of edges to sample for the root: every processor computes its own count from the same plan
+		uint32_t edges_to_sample_locally = edges_per_processor.at(rank_);
 
 		//Take part in sampling
+		CC_PHASE_START(SAMPLE);
 		vector<Edge> samples = sample(edges_to_sample_locally);
+		CC_PHASE_STOP(SAMPLE);
 
-		// Gather samples
-		// Allocate space
-		vector<Edge> global_samples(number_of_edges_to_sample);
-		// Calculate displacement vector
-		vector<int32_t> relative_displacements(edges_per_processor); // Copy
-		// Add a zero at the beginning and remove the last element
-		relative_displacements.insert(relative_displacements.begin(), 0); // Start at offset zero
-		relative_displacements.pop_back();								  // Last element not needed
-
-		vector<int32_t> displacements;
-		partial_sum(relative_displacements.begin(), relative_displacements.end(), back_inserter(displacements));
-		/*
-		Explanation of partial_sum:
-		int val[] = {1,2,3,4,5};
-		vector<int> result;
-		partial_sum(val, val + 5, result);
-		result now contains: 1 3 6 10 15
-		*/
-
-		// Gather the samples
-		// MPI_Gatherv Gathers together values from a group of processes. The values can have different lengths
-		MPI_Gatherv(
-			samples.data(),
-			edges_to_sample_locally,
-			mpi_edge_t_,
-			global_samples.data(),
-			edges_per_processor.data(),
-			displacements.data(),
-			mpi_edge_t_,
-			0,
-			communicator_);
-
-		assert(global_samples.size() == number_of_edges_to_sample);
-
-		//Shuffle to ensure random order for the prefix
-		shuffle(global_samples.begin(), global_samples.end(), random_engine_);
+		// Edges contracted by the root: every sample, or the spanning forest of the samples with the tree contraction
+		vector<Edge> global_samples;
+		if (treeContraction())
+		{
+			CC_PHASE(CONTRACT);
+			global_samples = contractOnTree(samples);
+		}
+		else
+		{
+			CC_PHASE(GATHER);
+			CC_PHASE_BYTES(GATHER, samples.size() * sizeof(Edge));
+			// Gather samples
+			// Allocate space
+			global_samples.resize(number_of_edges_to_sample);
+			// Calculate displacement vector
+			vector<int32_t> relative_displacements(edges_per_processor); // Copy
+			// Add a zero at the beginning and remove the last element
+			relative_displacements.insert(relative_displacements.begin(), 0); // Start at offset zero
+			relative_displacements.pop_back();								  // Last element not needed
+
+			vector<int32_t> displacements;
+			partial_sum(relative_displacements.begin(), relative_displacements.end(), back_inserter(displacements));
+			/*
+			Explanation of partial_sum:
+			int val[] = {1,2,3,4,5};
+			vector<int> result;
+			partial_sum(val, val + 5, result);
+			result now contains: 1 3 6 10 15
+			*/
+
+			// Gather the samples
+			// MPI_Gatherv Gathers together values from a group of processes. The values can have different lengths
+			MPI_Gatherv(
+				samples.data(),
+				edges_to_sample_locally,
+				mpi_edge_t_,
+				global_samples.data(),
+				edges_per_processor.data(),
+				displacements.data(),
+				mpi_edge_t_,
+				0,
+				communicator_);
+
+			assert(global_samples.size() == number_of_edges_to_sample);
+
+			//Shuffle to ensure random order for the prefix
+			shuffle(global_samples.begin(), global_samples.end(), random_engine_);
+		}
 
 		/**
 		 * Incremental prefix scan
 		 */
 		vertex_map.resize(vertex_count_); // Resize the vertex_map to the size of the vertex count not needed but okay
 		uint32_t resulting_vertex_count = 0;
-		prefixConnectedComponents(global_samples, vertex_map, target_size_, resulting_vertex_count);
+		CC_PHASE_START(CONTRACT);
+		double root_start = MPI_Wtime();
+		// Once the target size is reached, the remaining edges are contracted completely: the target would stop the progress
+		uint32_t target_size = vertex_count_ > target_size_ ? target_size_ : 1;
+		prefixConnectedComponents(global_samples, vertex_map, target_size, resulting_vertex_count);
+		double root_time = MPI_Wtime() - root_start;
+		CC_PHASE_STOP(CONTRACT);
+
+		{
+			string str = "Round - " + to_string(rounds_) + " Sampled edges: " + to_string(number_of_edges_to_sample) + " Contracted edges: " + to_string(global_samples.size()) + " Vertices: " + to_string(vertex_count_) + " -> " + to_string(resulting_vertex_count) + " Root time: " + to_string(root_time) + " seconds\n";
+			cout << str;
+		}
 
 		vertex_count_ = resulting_vertex_count;
 
@@ -274,14 +565,21 @@ public:
 	 */
 	void prefixConnectedComponents(const vector<Edge> &edges, vector<uint32_t> &vertex_map, uint32_t components_count, uint32_t &resulting_vertex_count)
 	{
-		// Create a disjoint set for the vertices
-		DisjointSets<uint32_t> dsets(vertex_map.size());
-
 		if (components_count == 0 || vertex_map.size() == 0)
 		{
 			return;
 		}
 
+		// Without an intermediate target the order of the edges does not matter: contract them with all the threads
+		if (components_count <= 1)
+		{
+			parallelConnectedComponents(edges, vertex_map, resulting_vertex_count);
+			return;
+		}
+
+		// Create a disjoint set for the vertices
+		DisjointSets<uint32_t> dsets(vertex_map.size());
+
 		uint32_t components_active = vertex_map.size();
 
 		for (uint32_t i = 0; i < edges.size() && components_active > components_count; i++)
@@ -295,48 +593,200 @@ public:
 		}
 
 		// Also relabel the components to be in [0, new_vertex_count)!
-		const uint64_t mapping_undefined = -1l;
-		vector<uint64_t> component_labels(vertex_map.size(), mapping_undefined);
+		const uint32_t mapping_undefined = -1;
+		vector<uint32_t> component_labels(vertex_map.size(), mapping_undefined);
 		uint32_t next_label = 0;
 		for (uint32_t j = 0; j < vertex_map.size(); j++)
 		{
-			if (component_labels.at(dsets.find(j)) == mapping_undefined)
+			uint32_t root = dsets.find(j);
+			if (component_labels[root] == mapping_undefined)
 			{
-				component_labels.at(dsets.find(j)) = next_label++;
+				component_labels[root] = next_label++;
 			}
 
-			vertex_map.at(j) = component_labels.at(dsets.find(j));
+			vertex_map[j] = component_labels[root];
 		}
 
 		resulting_vertex_count = components_active;
 		return ;
 	}
 
+	/**
+	 * Contract all the edges with the OpenMP threads (concurrent union-find) and relabel the components
+	 * to be in [0, resulting_vertex_count), in the order of their smallest vertex like the sequential version
+	 * @param edges array of {edge_count >= 0} edges
+	 * @param [out] vertex_map preallocated map of {vertex_count > 0} vertices
+	 * @param [out] resulting_vertex_count how many vertices remain
+	 */
+	void parallelConnectedComponents(const vector<Edge> &edges, vector<uint32_t> &vertex_map, uint32_t &resulting_vertex_count)
+	{
+		uint32_t vertex_count = vertex_map.size();
+		ConcurrentDisjointSets dsets(vertex_count);
+
+		#pragma omp parallel
+		{
+			CC_THREAD_SPAN(CONTRACT);
+			#pragma omp for schedule(static) nowait
+			for (size_t i = 0; i < edges.size(); i++)
+				dsets.unify(edges[i].from, edges[i].to);
+		}
+
+		// One find per vertex: the root is the smallest vertex of the component
+		#pragma omp parallel
+		{
+			CC_THREAD_SPAN(CONTRACT);
+			#pragma omp for nowait
+			for (uint32_t j = 0; j < vertex_count; j++)
+				vertex_map[j] = dsets.find(j);
+		}
+
+		// The parents are not needed anymore: reuse them for the labels of the roots
+		vector<uint32_t> &root_labels = dsets.data();
+		vector<uint32_t> thread_offsets(omp_get_max_threads() + 1, 0);
+
+		#pragma omp parallel
+		{
+			CC_THREAD_SPAN(CONTRACT);
+			int thread = omp_get_thread_num(), threads = omp_get_num_threads();
+			uint32_t first = uint64_t(vertex_count) * thread / threads;
+			uint32_t last = uint64_t(vertex_count) * (thread + 1) / threads;
+
+			// Count the roots of the block of the thread
+			uint32_t roots = 0;
+			for (uint32_t j = first; j < last; j++)
+				if (vertex_map[j] == j)
+					roots++;
+			thread_offsets[thread + 1] = roots;
+
+			// Prefix sum of the counts: the first label of every block
+			#pragma omp barrier
+			#pragma omp single
+			{
+				partial_sum(thread_offsets.begin(), thread_offsets.begin() + threads + 1, thread_offsets.begin());
+				resulting_vertex_count = thread_offsets[threads];
+			}
+
+			// Compact the labels of the roots
+			uint32_t next_label = thread_offsets[thread];
+			for (uint32_t j = first; j < last; j++)
+				if (vertex_map[j] == j)
+					root_labels[j] = next_label++;
+
+			// Every vertex takes the label of its root
+			#pragma omp barrier
+			for (uint32_t j = first; j < last; j++)
+				vertex_map[j] = root_labels[vertex_map[j]];
+		}
+	}
+
 	/**
 	 * Maps edge endpoints after contraction.
 	 * @param vertex_map The root must contain a valid vertex mapping to apply.
-	 *                   vertex_map must be of the right size (number of vertices before applying the mapping).
+	 *                   vertex_map must be of the right size (number of vertices before applying the mapping),
+	 *                   except at the non-root processes when the map is shared by the node.
+	 * @param map_size number of vertices before applying the mapping
 	 */
-	void receiveAndApplyMapping(vector<uint32_t> &vertex_map)
+	void receiveAndApplyMapping(vector<uint32_t> &vertex_map, uint32_t map_size)
 	{
-		// MPI_Bcast Broadcasts a message from the process with rank "root" to all other processes of the communicator 
-		MPI_Bcast(vertex_map.data(), vertex_map.size(), MPI_UINT32_T, 0, communicator_);
+		if (shared_map_)
+		{
+			// The root writes the map in the memory of its node, the other nodes receive it through their leader
+			CC_PHASE_START(BCAST);
+			if (master())
+				copy(vertex_map.begin(), vertex_map.end(), shared_map_->data());
+			shared_map_->broadcast(map_size);
+			CC_PHASE_STOP(BCAST);
+			CC_PHASE_BYTES(BCAST, map_size * sizeof(uint32_t));
 
-		applyMapping(vertex_map);
+			CC_PHASE(APPLY);
+			applyMapping(shared_map_->data());
+		}
+		else if (compress_map_)
+		{
+			CC_PHASE_START(BCAST);
+			receiveCompressedMapping(vertex_map, map_size);
+			CC_PHASE_STOP(BCAST);
 
+			CC_PHASE(APPLY);
+			applyMapping(vertex_map.data());
+		}
+		else
+		{
+			// MPI_Bcast Broadcasts a message from the process with rank "root" to all other processes of the communicator 
+			CC_PHASE_START(BCAST);
+			MPI_Bcast(vertex_map.data(), map_size, MPI_UINT32_T, 0, communicator_);
+			CC_PHASE_STOP(BCAST);
+			CC_PHASE_BYTES(BCAST, map_size * sizeof(uint32_t));
+
+			CC_PHASE(APPLY);
+			applyMapping(vertex_map.data());
+		}
+
+		CC_PHASE(BCAST);
 		MPI_Bcast(&vertex_count_, 1, MPI_UINT32_T, 0, communicator_);
 	}
 
 	/**
-	 * Match `initiateSampling` at non-root nodes
+	 * Broadcasts the vertex map encoded by the root: bit-packed or run-length encoded when it is smaller.
+	 * Called on the root after the contraction, so vertex_count_ is already the number of labels of the map.
 	 */
-	void acceptSamplingRequest()
+	void receiveCompressedMapping(vector<uint32_t> &vertex_map, uint32_t map_size)
 	{
-		uint32_t edges_to_sample_locally;
-		MPI_Scatter(nullptr, 1, MPI_INT, &edges_to_sample_locally, 1, MPI_INT, 0, communicator_);
+		EncodedMapping encoded;
+		double encode_time = 0, decode_time = 0;
+
+		if (master())
+		{
+			double start = MPI_Wtime();
+			encoded = MappingCodec::encode(vertex_map, vertex_count_);
+			encode_time = MPI_Wtime() - start;
+		}
+
+		// Header first: encoding, bits per label and number of words
+		uint64_t header[3] = {encoded.encoding, encoded.bits, encoded.words.size()};
+		MPI_Bcast(header, 3, MPI_UINT64_T, 0, communicator_);
+		encoded.encoding = header[0];
+		encoded.bits = header[1];
+		encoded.words.resize(header[2]);
+		MPI_Bcast(encoded.words.data(), header[2], MPI_UINT64_T, 0, communicator_);
+		CC_PHASE_BYTES(BCAST, encoded.bytes());
+
+		if (!master())
+		{
+			double start = MPI_Wtime();
+			MappingCodec::decode(encoded, vertex_map.data(), map_size);
+			decode_time = MPI_Wtime() - start;
+		}
+
+		double max_decode_time;
+		MPI_Reduce(&decode_time, &max_decode_time, 1, MPI_DOUBLE, MPI_MAX, 0, communicator_);
 
+		if (master())
+		{
+			string str = "Round - " + to_string(rounds_) + " Mapping broadcast: " + to_string(encoded.bytes()) + " bytes (" + encoded.name() + ", raw " + to_string((uint64_t)map_size * sizeof(uint32_t)) + " bytes) Encode time: " + to_string(encode_time) + " seconds Decode time: " + to_string(max_decode_time) + " seconds\n";
+			cout << str;
+		}
+	}
+
+	/**
+	 * Match `initiateSampling` at non-root nodes
+	 * @param edges_to_sample_locally the share of the processor in the plan of edgesToSamplePerProcessor
+	 */
+	void acceptSamplingRequest(uint32_t edges_to_sample_locally)
+	{
+		CC_PHASE_START(SAMPLE);
 		vector<Edge> samples = sample(edges_to_sample_locally);
+		CC_PHASE_STOP(SAMPLE);
+
+		if (treeContraction())
+		{
+			CC_PHASE(CONTRACT);
+			contractOnTree(samples);
+			return;
+		}
 
+		CC_PHASE(GATHER);
+		CC_PHASE_BYTES(GATHER, samples.size() * sizeof(Edge));
 		MPI_Gatherv(
 			samples.data(),
 			edges_to_sample_locally,
@@ -350,23 +800,113 @@ public:
 	}
 
 	/**
-	 * Apply the map to all endpoints, dropping loops
+	 * Contract the samples of every process with a union-find, then merge the spanning forests up a binomial tree,
+	 * contracting again at every level. Every forest has less than vertex_count_ edges. Collective call
+	 * @param samples the edges sampled by this process
+	 * @return the spanning forest of all the samples at the root, an empty vector at the other processes
+	 */
+	vector<Edge> contractOnTree(const vector<Edge> &samples)
+	{
+		DisjointSets<uint32_t> dsets(vertex_count_);
+		vector<Edge> forest;
+		addToForest(samples, dsets, forest);
+
+		for (int32_t step = 1; step < group_size_; step <<= 1)
+		{
+			// Send the forest to the parent and leave the tree
+			if (rank_ % (2 * step) == step)
+			{
+				MPI_Send(forest.data(), forest.size(), mpi_edge_t_, rank_ - step, 0, communicator_);
+				return vector<Edge>();
+			}
+
+			// Receive the forest of the child, if there is one at this level
+			if (rank_ + step < group_size_)
+			{
+				MPI_Status status;
+				int32_t count;
+				MPI_Probe(rank_ + step, 0, communicator_, &status);
+				MPI_Get_count(&status, mpi_edge_t_, &count);
+
+				vector<Edge> child_forest(count);
+				MPI_Recv(child_forest.data(), count, mpi_edge_t_, rank_ + step, 0, communicator_, MPI_STATUS_IGNORE);
+
+				addToForest(child_forest, dsets, forest);
+			}
+		}
+
+		return forest; // NRVO
+	}
+
+	// Add to the forest the edges that join two different trees of dsets
+	void addToForest(const vector<Edge> &edges, DisjointSets<uint32_t> &dsets, vector<Edge> &forest)
+	{
+		for (const Edge &edge : edges)
+		{
+			uint32_t v1_set = dsets.find(edge.from), v2_set = dsets.find(edge.to);
+			if (v1_set != v2_set)
+			{
+				dsets.unify(v1_set, v2_set);
+				forest.push_back(edge);
+			}
+		}
+	}
+
+	/**
+	 * Apply the map to all endpoints, dropping loops. The slice is compacted in place
 	 * @param vertex_map
 	 */
-	void applyMapping(const vector<uint32_t> &vertex_map)
+	void applyMapping(const uint32_t *vertex_map)
 	{
-		vector<Edge> updated_edges;
+		size_t edge_count = edges_slice_.size();
+		Edge *edges = edges_slice_.data();
+		vector<size_t> thread_offsets(omp_get_max_threads() + 1, 0);
+		int thread_count = 1;
 
-		for (auto edge : edges_slice_)
+		#pragma omp parallel
 		{
-			edge.from = vertex_map.at(edge.from);
-			edge.to = vertex_map.at(edge.to);
-			if (edge.from != edge.to)
+			CC_THREAD_SPAN(APPLY);
+			int thread = omp_get_thread_num(), threads = omp_get_num_threads();
+			size_t first = edge_count * thread / threads;
+			size_t last = edge_count * (thread + 1) / threads;
+
+			// Every thread compacts its block at the beginning of the block
+			size_t kept = first;
+			for (size_t i = first; i < last; i++)
 			{
-				updated_edges.push_back(edge);
+				Edge edge = {vertex_map[edges[i].from], vertex_map[edges[i].to]};
+				if (edge.from != edge.to)
+				{
+					// The parallel edges are recognized only with the same orientation
+					if (dedup_edges_)
+						edge.normalize();
+					edges[kept++] = edge;
+				}
 			}
+			thread_offsets[thread + 1] = kept - first;
+
+			// Read after the parallel region only
+			#pragma omp single nowait
+			thread_count = threads;
+		}
+
+		// Move the blocks next to each other: in order, since a block can overwrite the one before it
+		size_t updated_count = thread_offsets[1];
+		for (int thread = 1; thread < thread_count; thread++)
+		{
+			size_t first = edge_count * thread / thread_count;
+			move(edges + first, edges + first + thread_offsets[thread + 1], edges + updated_count);
+			updated_count += thread_offsets[thread + 1];
+		}
+
+		if (dedup_edges_)
+		{
+			sort(edges, edges + updated_count);
+			size_t unique_count = unique(edges, edges + updated_count) - edges;
+			duplicate_edges_ += updated_count - unique_count;
+			updated_count = unique_count;
 		}
 
-		edges_slice_.swap(updated_edges);
+		edges_slice_.resize(updated_count);
 	}
 };
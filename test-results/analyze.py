@@ -1,59 +1,78 @@
 #!/usr/bin/env python3
 
+# Speedup and efficiency plots from the database of benchmark.py
+#   ./analyze.py [results.csv] [--graph GRAPH] [--commit COMMIT]
+# Without --graph the graph of the last row is plotted, without --commit all the commits are pooled
+
+import argparse
+import csv
+import os
+import sys
+
 import matplotlib.pyplot as plt
 import numpy as np
 
-SERIAL = 65
-n_proc = np.array([1, 2, 4, 8, 16, 32, 64])
+LABELS = {
+    'ppopp': 'PPoPP 2018 MPI',
+    'mpi': 'Deterministic MPI',
+    'omp-det': 'Deterministic OpenMP',
+    'omp-rand': 'Randomized OpenMP',
+}
+
+parser = argparse.ArgumentParser()
+parser.add_argument('database', nargs='?', default=os.path.join(os.path.dirname(os.path.abspath(__file__)), 'results.csv'))
+parser.add_argument('--graph')
+parser.add_argument('--commit')
+args = parser.parse_args()
 
-MPI_ppOpp = [87, 71, 52, 48, 37, 34, 35]
-MPI_my = [177, 108, 95, 52, 44, 40, 42]
-OPENMP_det = [168, 175, 117, 109, 84, 66, 52]
-OPENMP_rand = [1061, 747, 481, 413, 355, 281, 239]
+with open(args.database, newline='') as file:
+    rows = list(csv.DictReader(file))
 
-# Calc Speedup
-speedup_ppOpp = [SERIAL / MPI_ppOpp[i] for i in range(len(MPI_ppOpp))]
-speedup_my = [SERIAL / MPI_my[i] for i in range(len(MPI_my))]   
-speedup_det = [SERIAL / OPENMP_det[i] for i in range(len(OPENMP_det))]
-speedup_rand = [SERIAL / OPENMP_rand[i] for i in range(len(OPENMP_rand))]
+graph = args.graph or rows[-1]['graph']
+rows = [row for row in rows if row['graph'] == graph and (args.commit is None or row['commit'] == args.commit)]
+if any(row['correct'] != '1' for row in rows):
+    print('Warning: some runs have a wrong number of components')
 
+# Median compute time of every engine and number of processors (ranks for MPI, threads for OpenMP)
+times = {}
+for row in rows:
+    processors = max(int(row['ranks']), int(row['threads']))
+    times.setdefault(row['engine'], {}).setdefault(processors, []).append(float(row['compute_time']))
+
+# The speedup is relative to the serial engine (always recorded by benchmark.py, not by its older versions)
+if 'serial' not in times:
+    sys.exit('No serial run of ' + graph + (' at commit ' + args.commit if args.commit else '') +
+             ' in ' + args.database + ': the speedup needs the serial baseline, run benchmark.py again')
+SERIAL = np.median(times['serial'][1])
+n_proc = {}
+speedup = {}
+for engine in LABELS:
+    if engine in times:
+        n_proc[engine] = np.array(sorted(times[engine]))
+        speedup[engine] = np.array([SERIAL / np.median(times[engine][p]) for p in n_proc[engine]])
+
+all_proc = sorted(set(p for engine in n_proc for p in n_proc[engine]))
 
 # Plot Speedup
 plt.figure(figsize=(6, 6))
-plt.plot(n_proc[0:len(speedup_ppOpp)], speedup_ppOpp, marker='o', label='PPoPP 2018 MPI')
-plt.plot(n_proc[0:len(speedup_my)], speedup_my, marker='o', label='Deterministic MPI')
-plt.plot(n_proc[0:len(speedup_det)], speedup_det, marker='o', label='Deterministic OpenMP')
-plt.plot(n_proc[0:len(speedup_rand)], speedup_rand, marker='o', label='Randomized OpenMP')
-plt.xticks(n_proc[1:len(n_proc)])
+for engine in speedup:
+    plt.plot(n_proc[engine], speedup[engine], marker='o', label=LABELS[engine])
+plt.xticks(all_proc)
 plt.xlabel('Number of processors')
 plt.ylabel('Speedup')
-#plt.title('Speedup')
+plt.title(graph)
 plt.grid()
 plt.legend()
 plt.show()
 
-# Calc Efficiency
-efficiency_my = [speedup_my[i] / n_proc[i] for i in range(len(speedup_my))]
-efficiency_ppOpp = [speedup_ppOpp[i] / n_proc[i] for i in range(len(speedup_ppOpp))]
-efficiency_det = [speedup_det[i] / n_proc[i] for i in range(len(speedup_det))]
-efficiency_rand = [speedup_rand[i] / n_proc[i] for i in range(len(speedup_rand))]
-
 # Plot Efficiency
 plt.figure(figsize=(6, 6))
-
-plt.plot(n_proc[0:len(speedup_ppOpp)], efficiency_ppOpp, marker='o', label='PPoPP 2018 MPI')
-plt.plot(n_proc[0:len(speedup_my)], efficiency_my, marker='o', label='Deterministic MPI')
-plt.plot(n_proc[0:len(speedup_det)], efficiency_det, marker='o', label='Deterministic OpenMP')
-plt.plot(n_proc[0:len(speedup_rand)], efficiency_rand, marker='o', label='Randomized OpenMP')
+for engine in speedup:
+    plt.plot(n_proc[engine], speedup[engine] / n_proc[engine], marker='o', label=LABELS[engine])
 plt.xlabel('Number of processors')
 plt.ylabel('Efficiency')
-#plt.title('Efficiency')
-plt.xticks(n_proc[1:len(n_proc)])
+plt.title(graph)
+plt.xticks(all_proc)
 plt.grid()
 plt.legend()
 plt.show()
-
-
-
-
-
@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+
+# End-to-end benchmark harness: runs the engines of the unified driver (CC-Library/cc.out, cc_mpi.out)
+# over a set of graphs, thread counts, rank counts and repetitions, checks every component count
+# against the serial engine and appends one row per run to a CSV database (and its JSON copy).
+# analyze.py plots the speedup and the efficiency from that database.
+# The drivers must be the instrumented build (make clean && make INSTRUMENT=1 all mpi): the time of every
+# phase comes from cc --report, its slowest process (time_max of the totals) is the <phase>_time column.
+#
+# Example:
+#   ./benchmark.py --graphs ../input/medium2.txt gen:rmat:18:16 --threads 1 2 4 8 --ranks 1 2 4 8 --reps 3
+
+import argparse
+import csv
+import datetime
+import json
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+LIBRARY = os.path.normpath(os.path.join(HERE, '..', 'CC-Library'))
+
+SHARED_ENGINES = ['serial', 'omp-det', 'omp-rand']
+DISTRIBUTED_ENGINES = ['mpi', 'ppopp']
+
+# Phases of cc/Instrumentation.hpp, the phases an engine does not have stay empty
+PHASES = ['scatter', 'hook', 'reduce', 'find_roots', 'bcast', 'compute_next_edges', 'gather', 'sample', 'contract', 'apply']
+
+FIELDS = ['date', 'commit', 'graph', 'engine', 'ranks', 'threads', 'repetition',
+          'vertices', 'edges', 'iterations', 'components', 'reference_components', 'correct',
+          'read_time', 'compute_time', 'peak_memory_mb'] + [phase + '_time' for phase in PHASES]
+
+# Lines of the output block of cc.cpp
+PATTERNS = {
+    'vertices': r'Number of vertices: (\d+)',
+    'edges': r'Number of edges: (\d+)',
+    'iterations': r'Iterations: (\d+)',
+    'components': r'Number of connected components: (\d+)',
+    'read_time': r'Read time: ([\d.]+) seconds',
+    'compute_time': r'Elapsed time: ([\d.]+) seconds',
+    'peak_memory_mb': r'Peak memory: ([\d.]+) MB',
+}
+
+
+def git_commit():
+    try:
+        return subprocess.check_output(['git', 'rev-parse', '--short', 'HEAD'], cwd=HERE, text=True).strip()
+    except (OSError, subprocess.CalledProcessError):
+        return 'unknown'
+
+
+def run(args, graph, engine, ranks, threads):
+    env = dict(os.environ, OMP_NUM_THREADS=str(threads))
+    driver = os.path.join(LIBRARY, 'cc_mpi.out' if engine in DISTRIBUTED_ENGINES else 'cc.out')
+    if engine in DISTRIBUTED_ENGINES:
+        command = args.mpirun.split() + ['-np', str(ranks), driver]
+    else:
+        command = [driver]
+    command += [graph, '--engine=' + engine, '--threads=' + str(threads), '--seed=' + str(args.seed)]
+
+    report_fd, report_file = tempfile.mkstemp(suffix='.json')
+    os.close(report_fd)
+    command.append('--report=' + report_file)
+    try:
+        result = subprocess.run(command, env=env, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True)
+        if 'needs the instrumented build' in result.stdout:
+            sys.exit('No phase times: ' + driver + ' is not the instrumented build, rebuild the drivers with\n'
+                     '  make -C ' + LIBRARY + ' clean && make -C ' + LIBRARY + ' INSTRUMENT=1 all mpi')
+        if result.returncode != 0:
+            sys.exit('Failed: ' + ' '.join(command))
+        with open(report_file) as file:
+            totals = json.load(file)['totals']
+    finally:
+        os.remove(report_file)
+
+    row = {}
+    for field, pattern in PATTERNS.items():
+        match = re.search(pattern, result.stdout)
+        if match is None:
+            sys.exit('No "' + field + '" in the output of: ' + ' '.join(command))
+        row[field] = match.group(1)
+    for phase, values in totals.items():
+        row[phase + '_time'] = values['time_max']
+    return row
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Scaling runs of the connected components engines')
+    parser.add_argument('--graphs', nargs='+', required=True, help='input files or gen:SPEC')
+    parser.add_argument('--engines', nargs='+', default=SHARED_ENGINES + DISTRIBUTED_ENGINES,
+                        choices=SHARED_ENGINES + DISTRIBUTED_ENGINES)
+    parser.add_argument('--threads', nargs='+', type=int, default=[1], help='thread counts of the OpenMP engines')
+    parser.add_argument('--ranks', nargs='+', type=int, default=[1], help='process counts of the MPI engines')
+    parser.add_argument('--reps', type=int, default=3, help='repetitions of every configuration')
+    parser.add_argument('--seed', type=int, default=17, help='seed of the generated graphs')
+    parser.add_argument('--mpirun', default='mpirun', help='MPI launcher, with its options')
+    parser.add_argument('--output', default=os.path.join(HERE, 'results.csv'),
+                        help='CSV database, the rows are appended (a .json copy is written next to it)')
+    args = parser.parse_args()
+
+    date = datetime.datetime.now().isoformat(timespec='seconds')
+    commit = git_commit()
+    rows = []
+    failures = 0
+
+    for graph in args.graphs:
+        # The serial engine is the reference of the component count and the baseline of the speedup in analyze.py:
+        # its first run is always recorded, even when serial is not in --engines
+        reference_row = run(args, graph, 'serial', 1, 1)
+        reference = reference_row['components']
+
+        engines = args.engines if 'serial' in args.engines else ['serial'] + args.engines
+        for engine in engines:
+            if engine in DISTRIBUTED_ENGINES:
+                configurations = [(ranks, 1) for ranks in args.ranks]
+            elif engine == 'serial':
+                configurations = [(1, 1)]
+            else:
+                configurations = [(1, threads) for threads in args.threads]
+
+            for ranks, threads in configurations:
+                repetitions = args.reps if engine in args.engines else 1
+                for repetition in range(repetitions):
+                    if engine == 'serial' and repetition == 0:
+                        row = reference_row
+                    else:
+                        row = run(args, graph, engine, ranks, threads)
+                    row.update(date=date, commit=commit, graph=graph, engine=engine, ranks=ranks, threads=threads,
+                               repetition=repetition, reference_components=reference,
+                               correct=int(row['components'] == reference))
+                    rows.append(row)
+
+                    failures += 1 - row['correct']
+                    print('{graph} {engine} ranks={ranks} threads={threads} rep={repetition}: '
+                          '{compute_time} s, {components} components{flag}'.format(
+                              flag='' if row['correct'] else ' (expected ' + reference + ')', **row))
+
+    # Append to the database, rewritten with the columns of this version (the older rows have no phase times)
+    database = []
+    if os.path.exists(args.output):
+        with open(args.output, newline='') as file:
+            database = list(csv.DictReader(file))
+    database += [{field: str(row.get(field, '')) for field in FIELDS} for row in rows]
+    with open(args.output, 'w', newline='') as file:
+        writer = csv.DictWriter(file, fieldnames=FIELDS, restval='', extrasaction='ignore')
+        writer.writeheader()
+        writer.writerows(database)
+
+    with open(os.path.splitext(args.output)[0] + '.json', 'w') as file:
+        json.dump(database, file, indent=1)
+
+    if failures > 0:
+        sys.exit(str(failures) + ' runs with a wrong number of components')
+
+
+if __name__ == '__main__':
+    main()